@@ -0,0 +1,69 @@
+// Test code for Ultimate GPS Using Hardware Serial (e.g. GPS Flora or FeatherWing)
+//
+// This code shows how to have the library call your own functions when the
+// sentences you are interested in arrive, instead of polling newNMEAreceived()
+// and checking every field to see what changed.
+//
+// Tested and works great with the Adafruit GPS FeatherWing
+// ------> https://www.adafruit.com/products/3133
+// or Flora GPS
+// ------> https://www.adafruit.com/products/1059
+// but also works with the shield, breakout
+// ------> https://www.adafruit.com/products/1272
+// ------> https://www.adafruit.com/products/746
+//
+// Pick one up today at the Adafruit electronics shop
+// and help support open source hardware & software! -ada
+
+#include <Adafruit_GPS.h>
+
+// what's the name of the hardware serial port?
+#define GPSSerial Serial1
+
+// Connect to the GPS on the hardware port
+Adafruit_GPS GPS(&GPSSerial);
+
+// called each time an RMC sentence has been parsed into GPS
+void gotRMC(Adafruit_GPS *gps, nmea_id_t sentence) {
+  Serial.print("Fix: "); Serial.print((int)gps->fix);
+  if (gps->fix) {
+    Serial.print(" Location: ");
+    Serial.print(gps->latitudeDegrees, 6);
+    Serial.print(", ");
+    Serial.print(gps->longitudeDegrees, 6);
+    Serial.print(" Speed (knots): "); Serial.print(gps->speed);
+  }
+  Serial.println();
+}
+
+// called each time a GGA sentence has been parsed into GPS
+void gotGGA(Adafruit_GPS *gps, nmea_id_t sentence) {
+  Serial.print("Satellites: "); Serial.print((int)gps->satellites);
+  Serial.print(" Altitude: "); Serial.println(gps->altitude);
+}
+
+void setup()
+{
+  //while (!Serial);  // uncomment to have the sketch wait until Serial is ready
+
+  Serial.begin(115200);
+  Serial.println("Adafruit GPS library sentence handler test!");
+
+  // 9600 NMEA is the default baud rate for Adafruit MTK GPS's- some use 4800
+  GPS.begin(9600);
+  // turn on RMC (recommended minimum) and GGA (fix data) including altitude
+  GPS.sendCommand(PMTK_SET_NMEA_OUTPUT_RMCGGA);
+  GPS.sendCommand(PMTK_SET_NMEA_UPDATE_1HZ); // 1 Hz update rate
+
+  // ask for our functions to be called when the sentences arrive
+  GPS.onSentence(nmeaId("RMC"), gotRMC);
+  GPS.onSentence(nmeaId("GGA"), gotGGA);
+}
+
+void loop() // run over and over again
+{
+  // read whatever has arrived and parse it, calling gotRMC() and gotGGA()
+  GPS.update();
+
+  // the rest of loop() is free for other work
+}
@@ -32,6 +32,8 @@
 
 static bool strStartsWith(const char *str, const char *prefix);
 
+static const char locusTag[] = "$PMTKLOX,"; ///< starts a LOCUS dump line
+
 /**************************************************************************/
 /*!
     @brief Start the HW or SW serial port
@@ -73,6 +75,144 @@ bool Adafruit_GPS::begin(uint32_t baud_or_i2caddr) {
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief Find the baud rate the module is using, then move it up to the
+    fastest rate the port can take, for 10 Hz updates with all sentences on.
+    Call it after begin() on a serial connection. Each candidate rate is
+    tried, the 9600 power on default first, until a sentence with a good
+    checksum is heard. The module is then sent PMTK251 for each faster rate,
+    fastest first, until one is heard working. If the module can't be heard
+    after a switch, it is told to go back, in case it did switch, and the
+    port goes back to the rate that worked. Blocks for up to a few seconds,
+    and throws away the sentences it hears.
+    @param fastest The highest rate to try. SoftwareSerial is kept to 57600
+    or less, since it can't keep up with more.
+    @param listen Milliseconds to listen at each rate, long enough for a
+    couple of sentences at the module's update rate
+    @return The baud rate the module and port are left at, or 0 if the
+    module wasn't heard, leaving the port at 9600, or for I2C, SPI or a
+    Stream with no handler set by onBaudChange(), which have no baud rate
+    to change
+*/
+/**************************************************************************/
+uint32_t Adafruit_GPS::autoBaud(uint32_t fastest, uint16_t listen) {
+  static const uint32_t rates[] = {115200, 57600, 38400, 19200, 9600, 4800};
+  const uint8_t nRates = sizeof(rates) / sizeof(rates[0]);
+#if (defined(__AVR__) || ((defined(ARDUINO_UNOR4_WIFI) || defined(ESP8266)) && \
+                          !defined(NO_SW_SERIAL)))
+  if (gpsSwSerial && fastest > 57600)
+    fastest = 57600;
+#endif
+  uint32_t current = 0;
+  for (int8_t i = -1; i < nRates && !current; i++) {
+    uint32_t rate = i < 0 ? 9600 : rates[i];
+    if (i >= 0 && rate == 9600)
+      continue; // already tried first
+    if (!setPortBaud(rate))
+      return 0; // no way to change the rate
+    if (hearSentence(listen))
+      current = rate;
+  }
+  if (!current) {
+    setPortBaud(9600); // nothing heard, so leave it at the default
+    return 0;
+  }
+
+  for (uint8_t i = 0; i < nRates && rates[i] > current; i++) {
+    if (rates[i] > fastest)
+      continue;
+    switchBaud(rates[i]);
+    if (hearSentence(listen))
+      return rates[i];
+    switchBaud(current); // didn't work, so back to what did
+    if (!hearSentence(listen))
+      return 0;
+  }
+  return current;
+}
+
+/**************************************************************************/
+/*!
+    @brief Tell the module to change its baud rate with PMTK251, then change
+    the port to match.
+    @param baud The new rate
+*/
+/**************************************************************************/
+void Adafruit_GPS::switchBaud(uint32_t baud) {
+  char cmd[20];
+  sprintf(cmd, "$PMTK251,%lu", (unsigned long)baud);
+  addChecksum(cmd);
+  sendCommand(cmd);
+  if (gpsHwSerial)
+    gpsHwSerial->flush(); // let it go out at the old rate
+  else if (gpsStream)
+    gpsStream->flush();
+  delay(100); // and give the module time to switch
+  setPortBaud(baud);
+}
+
+/**************************************************************************/
+/*!
+    @brief Register a function for autoBaud() to call to change the baud
+    rate of a Stream passed to the constructor, e.g. one that wraps a
+    serial port with its own begin().
+    @param handler The function to call, or NULL to remove it
+*/
+/**************************************************************************/
+void Adafruit_GPS::onBaudChange(nmea_baud_handler_t handler) {
+  baudHandler = handler;
+}
+
+/**************************************************************************/
+/*!
+    @brief Change the baud rate of the serial port.
+    @param baud The new rate
+    @return true if the port was changed, false if there is no way to
+*/
+/**************************************************************************/
+bool Adafruit_GPS::setPortBaud(uint32_t baud) {
+#if (defined(__AVR__) || ((defined(ARDUINO_UNOR4_WIFI) || defined(ESP8266)) && \
+                          !defined(NO_SW_SERIAL)))
+  if (gpsSwSerial) {
+    gpsSwSerial->begin(baud);
+    return true;
+  }
+#endif
+  if (gpsHwSerial) {
+    gpsHwSerial->begin(baud);
+    return true;
+  }
+  if (gpsStream && baudHandler) {
+    baudHandler(this, baud);
+    return true;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Listen for a sentence with a good checksum, after throwing away
+    whatever was received before.
+    @param ms Milliseconds to listen for
+    @return true if one was heard
+*/
+/**************************************************************************/
+bool Adafruit_GPS::hearSentence(uint16_t ms) {
+  readAvailable();
+  flushNMEA();
+  uint32_t start = millis();
+  while (millis() - start < ms) {
+    readAvailable();
+    while (newNMEAreceived()) {
+      lastNMEA();
+      if (lastNMEAvalid())
+        return true;
+    }
+  }
+  return false;
+}
+
 /**************************************************************************/
 /*!
     @brief Constructor when using SoftwareSerial
@@ -157,11 +297,14 @@ void Adafruit_GPS::common_init(void) {
   gpsStream = NULL;   // port pointer in corresponding constructor
   gpsI2C = NULL;
   gpsSPI = NULL;
-  recvdflag = false;
+  _i2caddr = GPS_DEFAULT_I2C_ADDR;
   paused = false;
   lineidx = 0;
-  currentline = line1;
-  lastline = line2;
+  qHead = qTail = 0;
+  qHeld = false;
+  qOverruns = 0;
+  currentline = lines[qHead];
+  lastline = lines[NMEA_QUEUE_DEPTH - 1];
 
   hour = minute = seconds = year = month = day = fixquality = fixquality_3d =
       satellites = antenna = 0; // uint8_t
@@ -226,39 +369,59 @@ size_t Adafruit_GPS::available(void) {
     @return Bytes written - 1 on success, 0 on failure
 */
 /**************************************************************************/
-size_t Adafruit_GPS::write(uint8_t c) {
+size_t Adafruit_GPS::write(uint8_t c) { return write(&c, 1); }
+
+/**************************************************************************/
+/*!
+    @brief Write a block of bytes to the underlying transport - part of
+   'Print'-class functionality. print() and println() of a string come here
+   in one piece, so on I2C it goes out in as few transmissions as the Wire
+   buffer allows, GPS_MAX_I2C_TRANSFER bytes each, and on SPI in a single
+   transaction, rather than one per byte.
+    @param buffer The bytes to send
+    @param size Number of bytes
+    @return Bytes written, fewer than size if the transport failed
+*/
+/**************************************************************************/
+size_t Adafruit_GPS::write(const uint8_t *buffer, size_t size) {
 #if (defined(__AVR__) || ((defined(ARDUINO_UNOR4_WIFI) || defined(ESP8266)) && \
                           !defined(NO_SW_SERIAL)))
   if (gpsSwSerial) {
-    return gpsSwSerial->write(c);
+    return gpsSwSerial->write(buffer, size);
   }
 #endif
   if (gpsHwSerial) {
-    return gpsHwSerial->write(c);
+    return gpsHwSerial->write(buffer, size);
   }
   if (gpsStream) {
-    return gpsStream->write(c);
+    return gpsStream->write(buffer, size);
   }
   if (gpsI2C) {
-    gpsI2C->beginTransmission(_i2caddr);
-    if (gpsI2C->write(c) != 1) {
-      return 0;
-    }
-    if (gpsI2C->endTransmission(true) == 0) {
-      return 1;
+    size_t sent = 0;
+    while (sent < size) {
+      size_t n = size - sent;
+      if (n > GPS_MAX_I2C_TRANSFER)
+        n = GPS_MAX_I2C_TRANSFER;
+      gpsI2C->beginTransmission(_i2caddr);
+      n = gpsI2C->write(buffer + sent, n);
+      if (gpsI2C->endTransmission(true) != 0 || n == 0)
+        break; // not acknowledged, so this chunk didn't go
+      sent += n;
     }
+    return sent;
   }
   if (gpsSPI) {
     gpsSPI->beginTransaction(gpsSPI_settings);
     if (gpsSPI_cs >= 0) {
       digitalWrite(gpsSPI_cs, LOW);
     }
-    c = gpsSPI->transfer(c);
+    for (size_t i = 0; i < size; i++)
+      gpsSPI->transfer(buffer[i]); // the byte read back is just idle fill
     if (gpsSPI_cs >= 0) {
       digitalWrite(gpsSPI_cs, HIGH);
     }
     gpsSPI->endTransaction();
-    return 1;
+    return size;
   }
 
   return 0;
@@ -271,14 +434,14 @@ size_t Adafruit_GPS::write(uint8_t c) {
     Call very frequently and multiple times per opportunity or the buffer
     may overflow if there are frequent NMEA sentences. An 82 character NMEA
     sentence 10 times per second will require 820 calls per second, and
-    once a loop() may not be enough. Check for newNMEAreceived() after at
-    least every 10 calls, or you may miss some short sentences.
+    once a loop() may not be enough. Completed sentences wait in a queue of
+    NMEA_QUEUE_DEPTH slots, so a burst of sentences can be drained with
+    lastNMEA() once the burst is over.
     @return The character that we received, or 0 if nothing was available
 */
 /**************************************************************************/
 char Adafruit_GPS::read(void) {
-  static uint32_t firstChar = 0; // first character received in current sentence
-  uint32_t tStart = millis();    // as close as we can get to time char was sent
+  uint32_t tStart = millis(); // as close as we can get to time char was sent
   char c = 0;
 
   if (paused || noComms)
@@ -303,93 +466,479 @@ char Adafruit_GPS::read(void) {
     c = gpsStream->read();
   }
   if (gpsI2C) {
-    if (_buff_idx <= _buff_max) {
-      c = _i2cbuffer[_buff_idx];
-      _buff_idx++;
-    } else {
-      // refill the buffer!
-      if (gpsI2C->requestFrom((uint8_t)0x10, (uint8_t)GPS_MAX_I2C_TRANSFER,
-                              (uint8_t) true) == GPS_MAX_I2C_TRANSFER) {
-        // got data!
-        _buff_max = 0;
-        char curr_char = 0;
-        for (int i = 0; i < GPS_MAX_I2C_TRANSFER; i++) {
-          curr_char = gpsI2C->read();
-          if ((curr_char == 0x0A) && (last_char != 0x0D)) {
-            // skip duplicate 0x0A's - but keep as part of a CRLF
-            continue;
-          }
-          last_char = curr_char;
-          _i2cbuffer[_buff_max] = curr_char;
-          _buff_max++;
-        }
-        _buff_max--; // back up to the last valid slot
-        if ((_buff_max == 0) && (_i2cbuffer[0] == 0x0A)) {
-          _buff_max = -1; // ahh there was nothing to read after all
-        }
-        _buff_idx = 0;
-      }
-      return c;
+    if (_buff_idx > _buff_max) {
+      fillI2CBuffer();
+      return c; // the refill call doesn't return a character
     }
+    c = _i2cbuffer[_buff_idx++];
   }
 
   if (gpsSPI) {
-    do {
-      gpsSPI->beginTransaction(gpsSPI_settings);
-      if (gpsSPI_cs >= 0) {
-        digitalWrite(gpsSPI_cs, LOW);
-      }
-      c = gpsSPI->transfer(0xFF);
-      if (gpsSPI_cs >= 0) {
-        digitalWrite(gpsSPI_cs, HIGH);
+    if (_buff_idx > _buff_max && !fillSPIBuffer())
+      return c; // nothing but idle padding from the module
+    c = _spibuffer[_buff_idx++];
+  }
+  // Serial.print(c);
+
+  frameChar(c, tStart);
+  return c;
+}
+
+/**************************************************************************/
+/*!
+    @brief Feed a block of characters into the line assembler, as if each
+    had been returned by read(). Useful when the characters have already
+    been collected by DMA, a ring buffer in another driver, or a log file.
+
+    Each block is stamped with a single millis() call, so sentTime and
+    recvdTime for every sentence completed in the block are the time of the
+    call rather than the time of each character. Feed blocks promptly and
+    the difference is no more than the time it took the block to arrive.
+
+    Completed sentences are queued for lastNMEA(). A block holding more
+    sentences than the queue can hold will drop the newest ones, counted
+    by queueOverruns().
+    @param buf Pointer to the characters, which need not be 0 terminated
+    @param n Number of characters in buf
+    @return Number of complete sentences assembled
+*/
+/**************************************************************************/
+size_t Adafruit_GPS::feed(const char *buf, size_t n) {
+  size_t sentences = 0;
+  uint32_t tNow = millis(); // one time stamp for the whole block
+
+  while (n > 0) {
+    if (rxState == RX_FRAME && lineidx >= sizeof(locusTag) - 1) {
+      // copy the run of ordinary characters in bulk, as far as it fits, once
+      // frameChar() has had the chance to spot a LOCUS line
+      size_t room = (MAXLINELENGTH - 1) - lineidx;
+      size_t run = 0;
+      while (run < n && run < room && buf[run] != '\n' && buf[run] != '$' &&
+             buf[run] != '!')
+        run++;
+      memcpy((char *)currentline + lineidx, buf, run);
+      scanLine(lineidx, lineidx + run);
+      lineidx += run;
+      buf += run;
+      n -= run;
+      if (n == 0)
+        break;
+    }
+    // then let the framing deal with whatever stopped the run
+    sentences += frameChar(*buf++, tNow);
+    n--;
+  }
+  return sentences;
+}
+
+/**************************************************************************/
+/*!
+    @brief Read everything the GPS has sent and parse every sentence waiting,
+    calling the handlers set up with onSentence() and onValue() for each one
+    that parses. Call it from loop() in place of polling newNMEAreceived().
+    @return Number of sentences successfully parsed
+*/
+/**************************************************************************/
+uint8_t Adafruit_GPS::update(void) {
+  readAvailable();
+  uint8_t parsed = 0;
+  while (newNMEAreceived())
+    if (parse(lastNMEA()))
+      parsed++;
+  checkCommands(); // time out any that were never answered
+  if (locusHandler) {
+    locus_record_t r;
+    while (LOCUS_readRecords(&r, 1))
+      locusHandler(this, &r);
+  }
+  return parsed;
+}
+
+/**************************************************************************/
+/*!
+    @brief Read everything the transport has ready and feed it into the
+    line assembler in one pass, rather than a character per call to read().
+    Call it from loop() instead of calling read() until nothing is left.
+    @return Number of complete sentences assembled
+*/
+/**************************************************************************/
+size_t Adafruit_GPS::readAvailable(void) {
+  size_t sentences = 0;
+  if (paused || noComms)
+    return sentences;
+
+  Stream *port = gpsStream; // all of the serial flavours are Streams
+#if (defined(__AVR__) || ((defined(ARDUINO_UNOR4_WIFI) || defined(ESP8266)) && \
+                          !defined(NO_SW_SERIAL)))
+  if (gpsSwSerial)
+    port = gpsSwSerial;
+#endif
+  if (gpsHwSerial)
+    port = gpsHwSerial;
+
+  if (port) {
+    char buf[32];
+    int n;
+    while ((n = port->available()) > 0) {
+      if (n > (int)sizeof(buf))
+        n = sizeof(buf);
+      for (int i = 0; i < n; i++)
+        buf[i] = port->read();
+      sentences += feed(buf, n);
+    }
+  }
+
+  if (gpsI2C || gpsSPI) {
+    char *block = gpsI2C ? _i2cbuffer : _spibuffer;
+    // serve what is left in the buffer, then refill until the module has
+    // nothing more to give, with a limit in case it never runs dry
+    for (int blocks = 0; blocks < GPS_MAX_BLOCKS_PER_READ; blocks++) {
+      if (_buff_idx > _buff_max &&
+          !(gpsI2C ? fillI2CBuffer() : fillSPIBuffer()))
+        break;
+      sentences += feed(block + _buff_idx, _buff_max - _buff_idx + 1);
+      _buff_idx = _buff_max + 1;
+    }
+  }
+
+  return sentences;
+}
+
+/**************************************************************************/
+/*!
+    @brief Refill the I2C buffer with one block read from the module,
+    dropping the line feeds it uses as padding when it has nothing to send.
+
+    Polling an idle module wastes time on a shared bus, so after each
+    block of nothing but padding the wait before the next poll doubles, up
+    to GPS_I2C_MAX_BACKOFF ms. The module sends its sentences in a burst
+    once per fix, so the time between the starts of bursts is learned, and
+    the wait is cut short to poll promptly when the next burst is due.
+    @return True if the buffer now has characters to read
+*/
+/**************************************************************************/
+bool Adafruit_GPS::fillI2CBuffer(void) {
+  uint32_t now = millis();
+  if ((int32_t)(now - _i2cNextPoll) < 0)
+    return false; // still backing off
+
+  if (gpsI2C->requestFrom(_i2caddr, (uint8_t)GPS_MAX_I2C_TRANSFER,
+                          (uint8_t) true) == GPS_MAX_I2C_TRANSFER) {
+    // got data!
+    _buff_max = 0;
+    char curr_char = 0;
+    for (int i = 0; i < GPS_MAX_I2C_TRANSFER; i++) {
+      curr_char = gpsI2C->read();
+      if ((curr_char == 0x0A) && (last_char != 0x0D)) {
+        // skip duplicate 0x0A's - but keep as part of a CRLF
+        continue;
       }
-      gpsSPI->endTransaction();
-      // skip duplicate 0x0A's - but keep as part of a CRLF
-    } while (((c == 0x0A) && (last_char != 0x0D)) ||
-             (!isprint(c) && !isspace(c)));
+      last_char = curr_char;
+      _i2cbuffer[_buff_max] = curr_char;
+      _buff_max++;
+    }
+    _buff_max--; // back up to the last valid slot
+    if ((_buff_max == 0) && (_i2cbuffer[0] == 0x0A)) {
+      _buff_max = -1; // ahh there was nothing to read after all
+    }
+    _buff_idx = 0;
+  }
+
+  if (_buff_idx <= _buff_max) {
+    if (_i2cBackoff > 0) { // first data after idling, so a burst started
+      if (_i2cEpochStart != 0)
+        _i2cEpoch = now - _i2cEpochStart;
+      _i2cEpochStart = now;
+      _i2cBackoff = 0; // and poll flat out until it is over
+    }
+    _i2cNextPoll = now;
+    return true;
+  }
+
+  // nothing there, so wait a little longer each time
+  _i2cBackoff = _i2cBackoff ? _i2cBackoff * 2 : 1;
+  if (_i2cBackoff > GPS_I2C_MAX_BACKOFF)
+    _i2cBackoff = GPS_I2C_MAX_BACKOFF;
+  _i2cNextPoll = now + _i2cBackoff;
+  if (_i2cEpoch > 0) { // but not past the start of the next burst
+    uint32_t nextEpoch =
+        _i2cEpochStart + ((now - _i2cEpochStart) / _i2cEpoch + 1) * _i2cEpoch;
+    if ((int32_t)(_i2cNextPoll - nextEpoch) > 0)
+      _i2cNextPoll = nextEpoch;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Refill the SPI buffer by clocking out GPS_MAX_SPI_TRANSFER bytes
+    in a single transaction, rather than one transaction per byte. The
+    module pads with unprintable idle bytes when it has nothing to send,
+    and those are filtered out along with duplicate line feeds, just like
+    the per byte reads used to do.
+    @return True if the buffer now has characters to read
+*/
+/**************************************************************************/
+bool Adafruit_GPS::fillSPIBuffer(void) {
+  memset(_spibuffer, 0xFF, GPS_MAX_SPI_TRANSFER);
+  gpsSPI->beginTransaction(gpsSPI_settings);
+  if (gpsSPI_cs >= 0) {
+    digitalWrite(gpsSPI_cs, LOW);
+  }
+  gpsSPI->transfer(_spibuffer, GPS_MAX_SPI_TRANSFER);
+  if (gpsSPI_cs >= 0) {
+    digitalWrite(gpsSPI_cs, HIGH);
+  }
+  gpsSPI->endTransaction();
+
+  // compact the buffer in place, keeping only the real characters
+  _buff_max = -1;
+  for (int i = 0; i < GPS_MAX_SPI_TRANSFER; i++) {
+    char c = _spibuffer[i];
+    // skip duplicate 0x0A's - but keep as part of a CRLF
+    if (((c == 0x0A) && (last_char != 0x0D)) ||
+        (!isprint((uint8_t)c) && !isspace((uint8_t)c)))
+      continue;
     last_char = c;
+    _spibuffer[++_buff_max] = c;
   }
-  // Serial.print(c);
+  _buff_idx = 0;
+  return _buff_max >= 0;
+}
 
-  currentline[lineidx++] = c;
-  if (lineidx >= MAXLINELENGTH)
-    lineidx = MAXLINELENGTH -
-              1; // ensure there is someplace to put the next received character
+/**************************************************************************/
+/*!
+    @brief Add one character to the sentence being assembled.
+
+    A $ or ! always starts a fresh sentence. After sendBinary(), until the
+    next good sentence, 0x04 followed by $ between sentences starts an MTK
+    binary packet. If the sentence it interrupts
+    already has its checksum, the interrupted one is complete and is kept,
+    which splits the output of multiplexers that leave out CR/LF. Otherwise
+    it was cut short and is thrown away. A line feed ends a sentence. Lines
+    longer than MAXLINELENGTH are thrown away, along with everything up to
+    the next $ or !, as is anything else received between sentences.
+    @param c The character
+    @param t millis() when the character was received
+    @return 1 if a sentence was completed, 0 if not
+*/
+/**************************************************************************/
+uint8_t Adafruit_GPS::frameChar(char c, uint32_t t) {
+  uint8_t completed = 0;
+  if (rxState == RX_LOCUS && c != '$' && c != '!') {
+    locusChar(c);
+    return completed;
+  }
+  if (rxState == RX_BINARY) {
+    if (binIdx > 1 || c == 0x24) {
+      frameBinary(c);
+      return completed;
+    }
+    rxState = RX_HUNT; // just a stray 0x04, so carry on with c as usual
+    rxSkipped = true;
+  } else if (c == 0x04 && binExpected && rxState != RX_FRAME) {
+    rxState = RX_BINARY; // could be the start of an MTK binary packet
+    binRx[0] = c;
+    binIdx = 1;
+    return completed;
+  }
+  if (c == '$' || c == '!') {
+    if (rxState == RX_FRAME && lineidx > 0) {
+      if (rxStar && lineidx > rxStar + 2) {
+        newLine(t); // complete but for the CR/LF
+        completed = 1;
+      } else {
+        rxTruncated++;
+      }
+    } else if (rxState == RX_LOCUS) {
+      rxTruncated++; // and the records from it are forgotten
+      LOCUS_dumpErrors++;
+    } else if (rxSkipped) {
+      rxResyncs++;
+    }
+    rxSkipped = false;
+    rxState = RX_FRAME;
+    lineidx = 0;
+    rxSum = rxSumAtStar = rxStar = rxCommas = rxCommasAtStar = 0;
+    firstChar = t;
+    currentline[lineidx++] = c;
+    return completed;
+  }
+
+  if (rxState != RX_FRAME) {
+    if (rxState == RX_HUNT && c != '\r' && c != '\n')
+      rxSkipped = true; // stray characters between sentences
+    return completed;
+  }
 
+  if (lineidx >= MAXLINELENGTH - 1) { // no room left for c and the 0
+    rxOverruns++;
+    rxState = RX_DISCARD;
+    lineidx = 0;
+    return completed;
+  }
+  currentline[lineidx++] = c;
+  scanLine(lineidx - 1, lineidx);
+  if (lineidx == sizeof(locusTag) - 1 &&
+      !memcmp((const char *)currentline, locusTag, lineidx)) {
+    // too long to queue, so decode the rest of it on the fly
+    rxState = RX_LOCUS;
+    lineidx = 0;
+    lxField = 1;
+    lxType = lxStar = lxCheck = lxRecIdx = 0;
+    lxLine = 0;
+    lxHalf = lxBad = lxSkip = false;
+    lxPending = lxHead;
+    return completed;
+  }
   if (c == '\n') {
-    currentline[lineidx] = 0;
+    newLine(t); // time we got the end of the string
+    completed = 1;
+  }
+  return completed;
+}
 
-    if (currentline == line1) {
-      currentline = line2;
-      lastline = line1;
-    } else {
-      currentline = line1;
-      lastline = line2;
+/**************************************************************************/
+/*!
+    @brief Add one byte to the MTK binary packet being assembled. A packet is
+    0x04 0x24, a 16 bit little endian length for the whole packet, a 16 bit
+    packet ID, the data, an XOR checksum of everything from the length to the
+    end of the data, then CR LF. A good packet is handed over to readBinary()
+    if the last one has been read, otherwise it is lost and counted.
+    @param c The byte
+*/
+/**************************************************************************/
+void Adafruit_GPS::frameBinary(uint8_t c) {
+  binRx[binIdx++] = c;
+  if (binIdx < 4)
+    return;
+  uint16_t len = binRx[2] | (binRx[3] << 8);
+  if (len < 9 || len > MTK_BINARY_MAXLENGTH) {
+    binErrors++; // too short to be a packet, or too long to keep
+    rxState = RX_HUNT;
+    return;
+  }
+  if (binIdx < len)
+    return;
+  rxState = RX_HUNT;
+  uint8_t sum = 0;
+  for (uint16_t i = 2; i < len - 3; i++)
+    sum ^= binRx[i];
+  if (sum != binRx[len - 3] || binRx[len - 2] != '\r' ||
+      binRx[len - 1] != '\n' || __atomic_load_n(&binReady, __ATOMIC_ACQUIRE)) {
+    binErrors++;
+    return;
+  }
+  memcpy(binPacket, binRx, len);
+  __atomic_store_n(&binReady, true, __ATOMIC_RELEASE);
+}
+
+/**************************************************************************/
+/*!
+    @brief Keep the running checksum, comma count and '*' position for the
+    line being assembled up to date, so that nothing has to rescan the line
+    once it is complete.
+    @param from Index of the first new character in currentline
+    @param to Index one past the last new character
+*/
+/**************************************************************************/
+void Adafruit_GPS::scanLine(uint8_t from, uint8_t to) {
+  if (from == 0)
+    from = 1; // the $ or ! is not part of the checksum
+  for (uint8_t i = from; i < to; i++) {
+    char c = currentline[i];
+    if (c == '*') { // only the last one counts, so keep overwriting
+      rxStar = i;
+      rxSumAtStar = rxSum;
+      rxCommasAtStar = rxCommas;
+    } else if (c == ',') {
+      rxCommas++;
     }
+    rxSum ^= c;
+  }
+}
 
-    // Serial.println("----");
-    // Serial.println((char *)lastline);
-    // Serial.println("----");
-    lineidx = 0;
-    recvdflag = true;
-    recvdTime = millis(); // time we got the end of the string
-    sentTime = firstChar;
-    firstChar = 0; // there are no characters yet
-    return c;      // wait until next character to set time
+/**************************************************************************/
+/*!
+    @brief Terminate the current line, stamp the times and framing details
+    for it and publish it to the consumer. If the queue is full the new
+    sentence is dropped, since the older ones belong to the consumer until
+    it releases them. While sendTracked() commands are pending, $PMTK lines
+    are set aside for checkCommands() instead, so they aren't lost that way.
+    @param t millis() when the end of the sentence was received
+*/
+/**************************************************************************/
+void Adafruit_GPS::newLine(uint32_t t) {
+  uint8_t head = qHead;
+  uint8_t next = (head + 1) % NMEA_QUEUE_DEPTH;
+  currentline[lineidx] = 0;
+  bool checksumOK = rxStar && (rxStar + 2 < lineidx) &&
+                    (currentline[0] == '$' || currentline[0] == '!') &&
+                    (parseHex(currentline[rxStar + 1]) * 16 +
+                         parseHex(currentline[rxStar + 2]) ==
+                     rxSumAtStar);
+  if (checksumOK)
+    binExpected = false; // back to NMEA, so a 0x04 is just noise again
+
+  if (checksumOK && commandsPending && lineidx < PMTK_REPLY_LENGTH &&
+      !strncmp((const char *)currentline, "$PMTK", 5) && setReplyAside()) {
+    // kept for checkCommands(), and out of the queue whether it's full or not
+  } else if (next == __atomic_load_n(&qTail, __ATOMIC_ACQUIRE)) {
+    qOverruns++; // full, so lose this sentence and reuse the slot
+  } else {
+    nmea_line_t *info = &qInfo[head];
+    info->recvdTime = t; // time we got the end of the string
+    info->sentTime = firstChar;
+    info->star = rxStar;
+    info->fields = rxStar ? rxCommasAtStar + 1 : 0;
+    info->checksumOK = checksumOK;
+    // slot contents must be complete before the consumer can see the slot
+    __atomic_store_n(&qHead, next, __ATOMIC_RELEASE);
+    currentline = lines[next];
   }
+  lineidx = 0;
+  rxState = RX_HUNT;
+  rxSum = rxSumAtStar = rxStar = rxCommas = rxCommasAtStar = 0;
+  firstChar = 0; // there are no characters yet
+}
 
-  if (firstChar == 0)
-    firstChar = tStart;
-  return c;
+/**************************************************************************/
+/*!
+    @brief Copy the $PMTK line just finished into a free reply slot and hand
+    it to checkCommands().
+    @return True if it was set aside, false if every slot is still waiting
+    to be parsed, so it has to go in the queue as usual
+*/
+/**************************************************************************/
+bool Adafruit_GPS::setReplyAside(void) {
+  for (uint8_t i = 0; i < PMTK_REPLY_SLOTS; i++) {
+    if (__atomic_load_n(&replyReady[i], __ATOMIC_ACQUIRE))
+      continue;
+    strcpy(replies[i], (const char *)currentline);
+    __atomic_store_n(&replyReady[i], true, __ATOMIC_RELEASE);
+    return true;
+  }
+  return false;
 }
 
 /**************************************************************************/
 /*!
-    @brief Send a command to the GPS device
+    @brief Send a command to the GPS device, with the CR/LF, in one write()
     @param str Pointer to a string holding the command to send
 */
 /**************************************************************************/
-void Adafruit_GPS::sendCommand(const char *str) { println(str); }
+void Adafruit_GPS::sendCommand(const char *str) {
+  size_t len = strlen(str);
+  if (len + 2 > MAXLINELENGTH) {
+    println(str); // too long for a sentence anyway, so no need to hurry
+    return;
+  }
+  char cmd[MAXLINELENGTH];
+  memcpy(cmd, str, len);
+  cmd[len++] = '\r';
+  cmd[len++] = '\n';
+  write((const uint8_t *)cmd, len);
+}
 
 /**************************************************************************/
 /*!
@@ -397,7 +946,137 @@ void Adafruit_GPS::sendCommand(const char *str) { println(str); }
     @return True if received, false if not
 */
 /**************************************************************************/
-bool Adafruit_GPS::newNMEAreceived(void) { return recvdflag; }
+bool Adafruit_GPS::newNMEAreceived(void) { return pendingSentences() > 0; }
+
+/**************************************************************************/
+/*!
+    @brief How many received sentences are waiting for lastNMEA()
+    @return Number of sentences in the queue, up to NMEA_QUEUE_DEPTH - 1
+*/
+/**************************************************************************/
+uint8_t Adafruit_GPS::pendingSentences(void) {
+  uint8_t head = __atomic_load_n(&qHead, __ATOMIC_ACQUIRE);
+  return (head + NMEA_QUEUE_DEPTH - qTail) % NMEA_QUEUE_DEPTH - qHeld;
+}
+
+/**************************************************************************/
+/*!
+    @brief How many sentences have been dropped because the queue was full
+    when they arrived. If this keeps growing, call lastNMEA() more often or
+    increase NMEA_QUEUE_DEPTH.
+    @return Number of sentences lost since the object was created
+*/
+/**************************************************************************/
+uint32_t Adafruit_GPS::queueOverruns(void) { return qOverruns; }
+
+/**************************************************************************/
+/*!
+    @brief How many lines have been thrown away for being longer than
+    MAXLINELENGTH. Usually a sign of lost line feeds or a non-NMEA stream.
+    @return Number of overlong lines since the object was created
+*/
+/**************************************************************************/
+uint32_t Adafruit_GPS::lineOverruns(void) { return rxOverruns; }
+
+/**************************************************************************/
+/*!
+    @brief How many times stray characters between sentences had to be
+    skipped to find the next $ or !, e.g. after power up or a baud mismatch.
+    @return Number of resyncs since the object was created
+*/
+/**************************************************************************/
+uint32_t Adafruit_GPS::lineResyncs(void) { return rxResyncs; }
+
+/**************************************************************************/
+/*!
+    @brief How many sentences were cut short by the start of the next one
+    before their checksum arrived. Usually a sign of characters lost to a
+    full transport buffer, so call read() more often or raise the baud rate.
+    @return Number of truncated sentences since the object was created
+*/
+/**************************************************************************/
+uint32_t Adafruit_GPS::lineTruncations(void) { return rxTruncated; }
+
+/**************************************************************************/
+/*!
+    @brief Check to see if an MTK binary packet has been received, e.g. an
+    answer to sendBinary(). read() only looks for packets after
+    sendBinary(), until the module sends a good NMEA sentence again. Serial
+    and Stream connections pass binary through as it is. The SPI read
+    throws away unprintable characters, so no packet survives it, and the
+    I2C read drops any 0x0A that doesn't follow a 0x0D, which breaks a
+    packet that holds one.
+    @return True if a packet is waiting for readBinary()
+*/
+/**************************************************************************/
+bool Adafruit_GPS::newBinary(void) {
+  return __atomic_load_n(&binReady, __ATOMIC_ACQUIRE);
+}
+
+/**************************************************************************/
+/*!
+    @brief Take the MTK binary packet that has been received, if any, so that
+    read() can keep the next one.
+    @param id Set to the packet ID, e.g. MTK_BINARY_ACK
+    @param data Buffer for the packet data, MTK_BINARY_MAXLENGTH - 9 bytes
+    will always be enough, or NULL to skip the data
+    @param len Set to the number of data bytes, may be NULL
+    @return True if there was a packet, false if not
+*/
+/**************************************************************************/
+bool Adafruit_GPS::readBinary(uint16_t *id, uint8_t *data, uint16_t *len) {
+  if (!__atomic_load_n(&binReady, __ATOMIC_ACQUIRE))
+    return false;
+  uint16_t n = (binPacket[2] | (binPacket[3] << 8)) - 9;
+  *id = binPacket[4] | (binPacket[5] << 8);
+  if (data)
+    memcpy(data, binPacket + 6, n);
+  if (len)
+    *len = n;
+  __atomic_store_n(&binReady, false, __ATOMIC_RELEASE);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Send an MTK binary packet, adding the preamble, length, checksum
+    and CR LF, e.g. for commands to a module that has been left in binary
+    mode by an EPO loader. MTK_BINARY_SET_OUTPUT with a 0 byte then the baud
+    rate as 4 little endian bytes sends it back to NMEA sentences.
+    @param id The packet ID
+    @param data Pointer to the data, may be NULL if len is 0
+    @param len Number of data bytes
+*/
+/**************************************************************************/
+void Adafruit_GPS::sendBinary(uint16_t id, const uint8_t *data, uint16_t len) {
+  uint16_t total = len + 9;
+  uint8_t head[6] = {0x04,
+                     0x24,
+                     (uint8_t)total,
+                     (uint8_t)(total >> 8),
+                     (uint8_t)id,
+                     (uint8_t)(id >> 8)};
+  uint8_t tail[3] = {0, '\r', '\n'};
+  for (uint8_t i = 2; i < sizeof(head); i++)
+    tail[0] ^= head[i];
+  for (uint16_t i = 0; i < len; i++)
+    tail[0] ^= data[i];
+  write(head, sizeof(head));
+  if (len)
+    write(data, len);
+  write(tail, sizeof(tail));
+  binExpected = true; // the answer will be binary too
+}
+
+/**************************************************************************/
+/*!
+    @brief How many MTK binary packets were thrown away, for a length too
+    long for MTK_BINARY_MAXLENGTH, a bad checksum or end, or because the
+    previous packet hadn't been taken by readBinary() yet.
+    @return Number of lost packets since the object was created
+*/
+/**************************************************************************/
+uint32_t Adafruit_GPS::binaryErrors(void) { return binErrors; }
 
 /**************************************************************************/
 /*!
@@ -409,18 +1088,76 @@ void Adafruit_GPS::pause(bool p) { paused = p; }
 
 /**************************************************************************/
 /*!
-    @brief Returns the last NMEA line received and unsets the received flag
-    @return Pointer to the last line string
+    @brief Returns the oldest NMEA line received that has not been returned
+    yet and removes it from the queue. If the queue is empty, returns the
+    line returned last time.
+
+    The line stays valid, even if read() is called from an interrupt, until
+    the next call to lastNMEA() that finds a newer line waiting. Only then
+    is its slot handed back to read() for reuse.
+    @return Pointer to the line string
 */
 /**************************************************************************/
 char *Adafruit_GPS::lastNMEA(void) {
-  recvdflag = false;
+  uint8_t head = __atomic_load_n(&qHead, __ATOMIC_ACQUIRE);
+  uint8_t tail = qTail;
+  if (qHeld) {
+    uint8_t next = (tail + 1) % NMEA_QUEUE_DEPTH;
+    if (next == head)
+      return (char *)lastline; // nothing new, keep holding the old one
+    // done with the held slot, so release it back to the producer
+    __atomic_store_n(&qTail, next, __ATOMIC_RELEASE);
+    tail = next;
+  } else if (tail == head) {
+    return (char *)lastline; // nothing has ever been received
+  }
+  qHeld = true;
+  lastline = lines[tail];
+  lastInfo = qInfo[tail];
+  sentTime = lastInfo.sentTime;
+  recvdTime = lastInfo.recvdTime;
   return (char *)lastline;
 }
 
 /**************************************************************************/
 /*!
-    @brief Wait for a specified sentence from the device
+    @brief Whether the line last returned by lastNMEA() starts with $ or !
+    and has a matching checksum, worked out as it was received, so there
+    is no need to scan it again.
+    @return True if the line passed, false if not
+*/
+/**************************************************************************/
+bool Adafruit_GPS::lastNMEAvalid(void) { return qHeld && lastInfo.checksumOK; }
+
+/**************************************************************************/
+/*!
+    @brief Number of comma separated fields, including the $ name, before
+    the checksum in the line last returned by lastNMEA().
+    @return Number of fields, 0 if the line has no checksum
+*/
+/**************************************************************************/
+uint8_t Adafruit_GPS::lastNMEAfields(void) {
+  return qHeld ? lastInfo.fields : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Discard any sentences waiting in the queue, including the one
+    last returned by lastNMEA().
+*/
+/**************************************************************************/
+void Adafruit_GPS::flushNMEA(void) {
+  qHeld = false;
+  lastInfo.star = 0;
+  __atomic_store_n(&qTail, __atomic_load_n(&qHead, __ATOMIC_ACQUIRE),
+                   __ATOMIC_RELEASE);
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait for a specified sentence from the device. Counts sentences
+    rather than time, and throws away the ones that don't match, so
+    sendTracked() and waitForCommand() are better for PMTK commands.
     @param wait4me Pointer to a string holding the desired response
     @param max How long to wait, default is MAXWAITSENTENCE
     @param usingInterrupts True if using interrupts to read from the GPS
@@ -449,78 +1186,216 @@ bool Adafruit_GPS::waitForSentence(const char *wait4me, uint8_t max,
 
 /**************************************************************************/
 /*!
-    @brief Start the LOCUS logger
+    @brief Work out which $PMTK message answers a query command, for the
+    ones that reply with data rather than just an acknowledgement.
+    @param command The PMTK command number
+    @return The message after PMTK in the reply, e.g. nmeaId("705"), or 0 if
+    the command is only acknowledged
+*/
+/**************************************************************************/
+static nmea_id_t pmtkReply(uint16_t command) {
+  if (command == 183)
+    return nmeaId("LOG"); // LOCUS status
+  if ((command < 400 || command > 499) && command != 605 && command != 607)
+    return 0;
+  uint16_t r = command + 100; // e.g. $PMTK414 is answered by $PMTK514
+  return ((nmea_id_t)('0' + r / 100) << 24) |
+         ((nmea_id_t)('0' + r / 10 % 10) << 16) |
+         ((nmea_id_t)('0' + r % 10) << 8);
+}
+
+/**************************************************************************/
+/*!
+    @brief Send a PMTK command and keep track of it until parse() sees the
+    $PMTK001 acknowledgement, or for a query like PMTK_Q_RELEASE the reply
+    sentence, or it times out. Several commands can be waiting at once, up
+    to PMTK_MAX_COMMANDS. Until then read() keeps the $PMTK lines out of the
+    sentence queue for commandResult(), waitForCommand() or update() to
+    parse, so poll commandResult() from loop(), or register a handler with
+    onCommand() and keep calling update().
+    @param cmd The command, e.g. PMTK_SET_NMEA_UPDATE_1HZ
+    @param timeout Milliseconds to wait for the answer
+    @return Handle for commandResult() and waitForCommand(), or -1 if cmd
+    isn't a $PMTK command or PMTK_MAX_COMMANDS are already waiting, in which
+    case it isn't sent
+*/
+/**************************************************************************/
+int8_t Adafruit_GPS::sendTracked(const char *cmd, uint16_t timeout) {
+  if (strncmp(cmd, "$PMTK", 5) != 0 || !isDigit(cmd[5]))
+    return -1;
+  uint16_t command = atoi(cmd + 5);
+  for (int8_t i = 0; i < PMTK_MAX_COMMANDS; i++) {
+    if (commands[i].command)
+      continue;
+    commands[i].command = command;
+    commands[i].timeout = timeout;
+    commands[i].reply = pmtkReply(command);
+    commands[i].result = PMTK_PENDING;
+    commands[i].sent = millis();
+    commandsPending++; // read() starts setting $PMTK lines aside
+    sendCommand(cmd);
+    return i;
+  }
+  return -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief Find out how a command from sendTracked() turned out. Once the
+    answer has been collected here the handle is free for another command.
+    @param handle The handle from sendTracked()
+    @return PMTK_PENDING while waiting, the result once it is known, or
+    PMTK_NO_COMMAND for a handle not in use
+*/
+/**************************************************************************/
+pmtk_result_t Adafruit_GPS::commandResult(int8_t handle) {
+  if (handle < 0 || handle >= PMTK_MAX_COMMANDS || !commands[handle].command)
+    return PMTK_NO_COMMAND;
+  checkCommands();
+  uint8_t result = commands[handle].result;
+  if (result != PMTK_PENDING)
+    commands[handle].command = 0; // collected
+  return (pmtk_result_t)result;
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait for a command from sendTracked() to be answered or time out.
+    Only the $PMTK sentences that read() sets aside for the tracked commands
+    are parsed. The sentence queue isn't touched, so the line lastNMEA()
+    returned stays valid and the rest are left in order for it, though if
+    the wait is long enough for the queue to fill the newest are lost.
+    @param handle The handle from sendTracked()
+    @param usingInterrupts True if read() is already being called from an
+    interrupt, false to read the GPS here
+    @return The result, as from commandResult()
+*/
+/**************************************************************************/
+pmtk_result_t Adafruit_GPS::waitForCommand(int8_t handle,
+                                           bool usingInterrupts) {
+  if (handle < 0 || handle >= PMTK_MAX_COMMANDS || !commands[handle].command)
+    return PMTK_NO_COMMAND;
+  commandWaited = handle; // keep the answer for us, even with a handler
+  while (commands[handle].result == PMTK_PENDING) {
+    if (!usingInterrupts)
+      readAvailable();
+    checkCommands();
+  }
+  commandWaited = -1;
+  return commandResult(handle);
+}
+
+/**************************************************************************/
+/*!
+    @brief Register a function to call when each command from sendTracked()
+    is answered or times out. The handle is freed once the function has
+    been called, unless waitForCommand() is waiting on it.
+    @param handler The function to call, or NULL to go back to polling
+*/
+/**************************************************************************/
+void Adafruit_GPS::onCommand(pmtk_command_handler_t handler) {
+  commandHandler = handler;
+}
+
+/**************************************************************************/
+/*!
+    @brief Pass an acknowledgement or query reply from the module to the
+    oldest command waiting for it.
+    @param command The command number acknowledged, or 0 for a reply
+    @param reply The reply message, e.g. nmeaId("LOG"), or 0 for an
+    acknowledgement
+    @param result The pmtk_result_t, the flag from $PMTK001 or PMTK_REPLIED
+*/
+/**************************************************************************/
+void Adafruit_GPS::commandAnswered(uint16_t command, nmea_id_t reply,
+                                   uint8_t result) {
+  int8_t slot = -1;
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < PMTK_MAX_COMMANDS; i++) {
+    if (!commands[i].command || commands[i].result != PMTK_PENDING ||
+        (command ? commands[i].command != command
+                 : commands[i].reply != reply))
+      continue;
+    if (slot < 0 || now - commands[i].sent > now - commands[slot].sent)
+      slot = i;
+  }
+  if (slot < 0)
+    return;
+  if (command && result == PMTK_SUCCEEDED && commands[slot].reply)
+    return; // a query that was accepted, so wait on for its reply
+  commandDone(slot, result);
+}
+
+/**************************************************************************/
+/*!
+    @brief Record the result of a tracked command and call the handler.
+    @param slot Index into commands[]
+    @param result The pmtk_result_t
+*/
+/**************************************************************************/
+void Adafruit_GPS::commandDone(uint8_t slot, uint8_t result) {
+  commands[slot].result = result;
+  commandsPending--;
+  if (!commandHandler)
+    return; // wait for commandResult() to collect it
+  commandHandler(this, commands[slot].command, (pmtk_result_t)result);
+  if (slot != commandWaited)
+    commands[slot].command = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse the $PMTK lines read() has set aside for the tracked
+    commands, then time out the ones that have waited too long.
+*/
+/**************************************************************************/
+void Adafruit_GPS::checkCommands(void) {
+  for (uint8_t i = 0; i < PMTK_REPLY_SLOTS; i++) {
+    if (!__atomic_load_n(&replyReady[i], __ATOMIC_ACQUIRE))
+      continue;
+    parse(replies[i]);
+    __atomic_store_n(&replyReady[i], false, __ATOMIC_RELEASE);
+  }
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < PMTK_MAX_COMMANDS; i++)
+    if (commands[i].command && commands[i].result == PMTK_PENDING &&
+        now - commands[i].sent >= commands[i].timeout)
+      commandDone(i, PMTK_TIMED_OUT);
+}
+
+/**************************************************************************/
+/*!
+    @brief Start the LOCUS logger. Waits up to PMTK_TIMEOUT for the module
+    to acknowledge, parsing the sentences that arrive meanwhile.
     @return True on success, false if it failed
 */
 /**************************************************************************/
 bool Adafruit_GPS::LOCUS_StartLogger(void) {
-  sendCommand(PMTK_LOCUS_STARTLOG);
-  recvdflag = false;
-  return waitForSentence(PMTK_LOCUS_STARTSTOPACK);
+  return waitForCommand(sendTracked(PMTK_LOCUS_STARTLOG)) == PMTK_SUCCEEDED;
 }
 
 /**************************************************************************/
 /*!
-    @brief Stop the LOCUS logger
+    @brief Stop the LOCUS logger. Waits up to PMTK_TIMEOUT for the module
+    to acknowledge, parsing the sentences that arrive meanwhile.
     @return True on success, false if it failed
 */
 /**************************************************************************/
 bool Adafruit_GPS::LOCUS_StopLogger(void) {
-  sendCommand(PMTK_LOCUS_STOPLOG);
-  recvdflag = false;
-  return waitForSentence(PMTK_LOCUS_STARTSTOPACK);
+  return waitForCommand(sendTracked(PMTK_LOCUS_STOPLOG)) == PMTK_SUCCEEDED;
 }
 
 /**************************************************************************/
 /*!
-    @brief Read the logger status
+    @brief Read the logger status into the LOCUS_ variables. Waits up to
+    PMTK_TIMEOUT for the $PMTKLOG reply, parsing the sentences that arrive
+    meanwhile. The status is also updated whenever parse() sees $PMTKLOG, so
+    sendTracked(PMTK_LOCUS_QUERY_STATUS) gets it without waiting.
     @return True if we read the data, false if there was no response
 */
 /**************************************************************************/
 bool Adafruit_GPS::LOCUS_ReadStatus(void) {
-  sendCommand(PMTK_LOCUS_QUERY_STATUS);
-
-  if (!waitForSentence("$PMTKLOG"))
-    return false;
-
-  char *response = lastNMEA();
-  uint16_t parsed[10];
-  uint8_t i;
-
-  for (i = 0; i < 10; i++)
-    parsed[i] = -1;
-
-  response = strchr(response, ',');
-  for (i = 0; i < 10; i++) {
-    if (!response || (response[0] == 0) || (response[0] == '*'))
-      break;
-    response++;
-    parsed[i] = 0;
-    while ((response[0] != ',') && (response[0] != '*') && (response[0] != 0)) {
-      parsed[i] *= 10;
-      char c = response[0];
-      if (isDigit(c))
-        parsed[i] += c - '0';
-      else
-        parsed[i] = c;
-      response++;
-    }
-  }
-  LOCUS_serial = parsed[0];
-  LOCUS_type = parsed[1];
-  if (isAlpha(parsed[2])) {
-    parsed[2] = parsed[2] - 'a' + 10;
-  }
-  LOCUS_mode = parsed[2];
-  LOCUS_config = parsed[3];
-  LOCUS_interval = parsed[4];
-  LOCUS_distance = parsed[5];
-  LOCUS_speed = parsed[6];
-  LOCUS_status = !parsed[7];
-  LOCUS_records = parsed[8];
-  LOCUS_percent = parsed[9];
-
-  return true;
+  return waitForCommand(sendTracked(PMTK_LOCUS_QUERY_STATUS)) == PMTK_REPLIED;
 }
 
 /**************************************************************************/
@@ -46,11 +46,65 @@
 #endif                ///< library
 #define GPS_DEFAULT_I2C_ADDR                                                   \
   0x10 ///< The default address for I2C transport of GPS data
+#ifndef GPS_MAX_I2C_TRANSFER // inject on the compile command line to resize
 #define GPS_MAX_I2C_TRANSFER                                                   \
-  32 ///< The max number of bytes we'll try to read at once
+  32 ///< The max number of bytes we'll try to read at once. Can be raised up
+     ///< to the size of the Wire buffer, e.g. 128 on ESP32
+#endif
+#ifndef GPS_I2C_MAX_BACKOFF
+#define GPS_I2C_MAX_BACKOFF                                                    \
+  32 ///< Longest wait in ms between I2C polls while the module is idle
+#endif
 #define GPS_MAX_SPI_TRANSFER                                                   \
   100                     ///< The max number of bytes we'll try to read at once
+#define GPS_MAX_BLOCKS_PER_READ                                                \
+  16 ///< The most I2C/SPI blocks readAvailable() will read in one call
 #define MAXLINELENGTH 120 ///< how long are max NMEA lines to parse?
+#ifndef NMEA_QUEUE_DEPTH // inject on the compile command line to resize
+#ifdef ARDUINO_ARCH_AVR
+#define NMEA_QUEUE_DEPTH 3 ///< number of MAXLINELENGTH sentence slots
+#else
+#define NMEA_QUEUE_DEPTH 8 ///< number of MAXLINELENGTH sentence slots
+#endif
+#endif
+#if (NMEA_QUEUE_DEPTH < 3)
+#error "NMEA_QUEUE_DEPTH must be at least 3: filling, held and waiting slots"
+#endif
+#ifndef MTK_BINARY_MAXLENGTH // inject on the compile command line to resize
+#define MTK_BINARY_MAXLENGTH 64 ///< longest MTK binary packet read() keeps
+#endif
+#ifndef NMEA_MAX_EXTRA_SOURCES // inject on the compile command line to resize
+#define NMEA_MAX_EXTRA_SOURCES 4 ///< number of talkers addSource() can add
+#endif
+#ifndef NMEA_MAX_HANDLERS // inject on the compile command line to resize
+#define NMEA_MAX_HANDLERS 4 ///< number of handlers onSentence() can hold
+#endif
+#ifndef PMTK_MAX_COMMANDS // inject on the compile command line to resize
+#define PMTK_MAX_COMMANDS 4 ///< PMTK commands sendTracked() can wait on
+#endif
+#ifndef PMTK_REPLY_SLOTS // inject on the compile command line to resize
+#define PMTK_REPLY_SLOTS 2 ///< $PMTK answers read() can set aside at once
+#endif
+#define PMTK_REPLY_LENGTH 80 ///< longest $PMTK answer read() sets aside
+#ifndef LOCUS_RECORD_QUEUE // inject on the compile command line to resize
+#define LOCUS_RECORD_QUEUE 8 ///< LOCUS dump records read() can hold, > 6
+#endif
+#ifndef NMEA_SENTENCE_MASK // e.g. -DNMEA_SENTENCE_MASK=NMEA_MASK_RMC
+#define NMEA_SENTENCE_MASK 0xFFFFFFFFUL ///< sentences parse() starts out with
+#endif
+#ifndef NMEA_MAX_SATELLITES // inject on the compile command line to resize
+#define NMEA_MAX_SATELLITES 24 ///< satellites kept from GSV, all systems
+#endif
+#ifndef NMEA_MAX_VESSELS // inject on the compile command line to resize
+#define NMEA_MAX_VESSELS 16 ///< AIS vessels kept, least recently heard go
+#endif
+#ifndef NMEA_AIS_FRAGMENTS // inject on the compile command line to resize
+#define NMEA_AIS_FRAGMENTS 4 ///< multipart AIS messages assembled at once
+#endif
+#define NMEA_AIS_MAXBYTES 64 ///< longest AIS message kept, 512 bits
+#ifndef NMEA_MAX_FIELDS // inject on the compile command line to resize
+#define NMEA_MAX_FIELDS 24 ///< most fields parse() indexes, including the ID
+#endif
 #define NMEA_MAX_SENTENCE_ID                                                   \
   20 ///< maximum length of a sentence ID name, including terminating 0
 #define NMEA_MAX_SOURCE_ID                                                     \
@@ -65,6 +119,12 @@
 #include <SPI.h>
 #include <Wire.h>
 
+#if (GPS_MAX_I2C_TRANSFER > 255) ||                                            \
+    (defined(BUFFER_LENGTH) && (GPS_MAX_I2C_TRANSFER > BUFFER_LENGTH)) ||      \
+    (defined(I2C_BUFFER_LENGTH) && (GPS_MAX_I2C_TRANSFER > I2C_BUFFER_LENGTH))
+#error "GPS_MAX_I2C_TRANSFER is bigger than the Wire buffer can hold"
+#endif
+
 /// type for resulting code from running check()
 typedef enum {
   NMEA_BAD = 0, ///< passed none of the checks
@@ -77,6 +137,176 @@ typedef enum {
   NMEA_HAS_SENTENCE_P = 40 ///< has a recognized parseable sentence ID
 } nmea_check_t;
 
+/// Bits for the sentences that parse() can decode, to combine into a mask
+/// for wantSentences() or NMEA_SENTENCE_MASK
+typedef enum {
+  NMEA_MASK_GGA = 1UL << 0,  ///< GGA fix data
+  NMEA_MASK_GLL = 1UL << 1,  ///< GLL position
+  NMEA_MASK_GSA = 1UL << 2,  ///< GSA DOP and active satellites
+  NMEA_MASK_RMC = 1UL << 3,  ///< RMC recommended minimum
+  NMEA_MASK_TOP = 1UL << 4,  ///< PGTOP antenna status
+  NMEA_MASK_DBT = 1UL << 5,  ///< DBT depth below transducer
+  NMEA_MASK_HDM = 1UL << 6,  ///< HDM magnetic heading
+  NMEA_MASK_HDT = 1UL << 7,  ///< HDT true heading
+  NMEA_MASK_MDA = 1UL << 8,  ///< MDA meteorological composite
+  NMEA_MASK_MTW = 1UL << 9,  ///< MTW water temperature
+  NMEA_MASK_MWV = 1UL << 10, ///< MWV wind speed and angle
+  NMEA_MASK_RMB = 1UL << 11, ///< RMB and APB navigation to a waypoint
+  NMEA_MASK_TXT = 1UL << 12, ///< TXT text message
+  NMEA_MASK_VHW = 1UL << 13, ///< VHW water speed and heading
+  NMEA_MASK_VLW = 1UL << 14, ///< VLW distance through the water
+  NMEA_MASK_VPW = 1UL << 15, ///< VPW speed parallel to the wind
+  NMEA_MASK_VWR = 1UL << 16, ///< VWR relative wind
+  NMEA_MASK_WCV = 1UL << 17, ///< WCV waypoint closure velocity
+  NMEA_MASK_XTE = 1UL << 18, ///< XTE cross track error
+  NMEA_MASK_DPT = 1UL << 19, ///< DPT depth
+  NMEA_MASK_HDG = 1UL << 20, ///< HDG heading, deviation and variation
+  NMEA_MASK_MWD = 1UL << 21, ///< MWD wind direction and speed
+  NMEA_MASK_VTG = 1UL << 22, ///< VTG track made good and ground speed
+  NMEA_MASK_GSV = 1UL << 23, ///< GSV satellites in view
+  NMEA_MASK_VDM = 1UL << 24, ///< !AIVDM AIS messages from other vessels
+  NMEA_MASK_VDO = 1UL << 25, ///< !AIVDO AIS messages from our own vessel
+  NMEA_MASK_MTK = 1UL << 26, ///< $PMTK responses, always decoded
+  NMEA_MASK_ROT = 1UL << 27, ///< ROT rate of turn
+  NMEA_MASK_RPM = 1UL << 28, ///< RPM engine or shaft revolutions
+  NMEA_MASK_RSA = 1UL << 29, ///< RSA rudder angle
+  NMEA_MASK_VDR = 1UL << 30, ///< VDR set and drift of the current
+  NMEA_MASK_ZDA = 1UL << 31  ///< ZDA time and date
+} nmea_sentence_bit_t;
+
+/// How a PMTK command sent with sendTracked() turned out. The first four are
+/// the flag from the module's $PMTK001 acknowledgement.
+typedef enum {
+  PMTK_INVALID = 0,     ///< the module didn't recognise the command
+  PMTK_UNSUPPORTED = 1, ///< valid, but not supported by the module
+  PMTK_FAILED = 2,      ///< valid, but the action failed
+  PMTK_SUCCEEDED = 3,   ///< valid and done
+  PMTK_REPLIED = 4,     ///< a query, and its reply has been parsed
+  PMTK_PENDING = 5,     ///< still waiting for the module
+  PMTK_TIMED_OUT = 6,   ///< no answer before the timeout
+  PMTK_NO_COMMAND = 7   ///< not a command being tracked, or already collected
+} pmtk_result_t;
+
+/// The satellites in view from the last complete GSV group of each
+/// satellite system, as parallel arrays so a scan touches only what it needs
+typedef struct {
+  uint8_t count;                         ///< number of satellites listed
+  uint8_t prn[NMEA_MAX_SATELLITES];      ///< satellite number
+  char system[NMEA_MAX_SATELLITES];      ///< P GPS, L GLONASS, A Galileo,
+                                         ///< B BeiDou, Q QZSS, N unknown
+  int8_t elevation[NMEA_MAX_SATELLITES]; ///< degrees above the horizon
+  uint16_t azimuth[NMEA_MAX_SATELLITES]; ///< degrees from true north
+  uint8_t snr[NMEA_MAX_SATELLITES];      ///< dB-Hz, 0 if not tracked
+  bool used[NMEA_MAX_SATELLITES];        ///< listed in GSA as used in the fix
+} nmea_satellites_t;
+
+/// What is known about a vessel from its AIS position and static data
+/// reports, with "not available" values where it hasn't said
+typedef struct {
+  uint32_t mmsi;           ///< Maritime Mobile Service Identity, 0 if unused
+  int32_t latitude_fixed;  ///< 1/10000000 degree, 910000000 if unknown
+  int32_t longitude_fixed; ///< 1/10000000 degree, 1810000000 if unknown
+  uint16_t sog;            ///< speed over ground in 0.1 knot, 1023 if unknown
+  uint16_t cog;            ///< course over ground in 0.1 degree, 3600 if
+                           ///< unknown
+  uint16_t heading;        ///< true heading in degrees, 511 if unknown
+  uint8_t status;          ///< navigation status, 15 if unknown
+  uint8_t shipType;        ///< ship and cargo type, 0 if unknown
+  char name[21];           ///< vessel name, empty if unknown
+  char callsign[8];        ///< radio call sign, empty if unknown
+  uint32_t lastHeard;      ///< millis() when the last report arrived
+} nmea_vessel_t;
+
+/// One basic LOCUS log record, decoded by read() from a $PMTKLOX flash dump
+typedef struct {
+  uint32_t utc;    ///< seconds since 1970-01-01 00:00 UTC
+  float latitude;  ///< degrees, -ve south
+  float longitude; ///< degrees, -ve west
+  int16_t height;  ///< metres above sea level
+  uint16_t index;  ///< position in the log, counting from 0
+  uint8_t fix;     ///< fix type as logged by the module
+} locus_record_t;
+
+/// One fix from parseBatch(), merged from the GGA, RMC and GLL sentences
+/// that share a time, with the position in the same fixed point form as
+/// latitude_fixed and longitude_fixed
+typedef struct {
+  uint32_t time;           ///< UTC as hhmmssmmm, e.g. 123519250
+  uint32_t date;           ///< UTC as ddmmyy from the last RMC, 0 if none
+  int32_t latitude_fixed;  ///< 1/10000000 degree
+  int32_t longitude_fixed; ///< 1/10000000 degree
+  float altitude;          ///< metres above MSL
+  float speed;             ///< knots over ground
+  float angle;             ///< course in degrees from true north
+  float HDOP;              ///< horizontal dilution of precision
+  uint8_t fixquality;      ///< 0, 1, 2 = Invalid, GPS, DGPS
+  uint8_t satellites;      ///< number of satellites in use
+  bool fix;                ///< had a fix
+} nmea_fix_t;
+
+/// Counts kept by parseBatch(), added to on each call
+typedef struct {
+  size_t bytes;       ///< bytes used, up to the end of the last whole line
+  uint32_t lines;     ///< lines that weren't blank
+  uint32_t parsed;    ///< sentences decoded
+  uint32_t rejected;  ///< lines with no $, no checksum or a bad checksum
+  uint32_t skipped;   ///< good sentences that aren't decoded or are masked
+  uint32_t dropped;   ///< GGA, RMC and GLL that didn't fit in the array
+  uint32_t type[32];  ///< sentences decoded, by NMEA_MASK_ bit number
+} nmea_batch_stats_t;
+
+/// Framing details worked out by read() as each sentence arrives
+typedef struct {
+  uint32_t sentTime;  ///< millis() when the first character arrived
+  uint32_t recvdTime; ///< millis() when the line feed arrived
+  uint8_t star;       ///< index of the last '*' in the line, 0 if none
+  uint8_t fields;     ///< number of comma separated fields before the '*'
+  bool checksumOK;    ///< starts with $ or ! and has a matching checksum
+} nmea_line_t;
+
+/// A source or sentence ID like "GP" or "GGA" packed into an integer, first
+/// character in the top byte, so IDs compare and copy without strings. Only
+/// the first four characters of longer, unknown IDs are kept.
+typedef uint32_t nmea_id_t;
+
+/**************************************************************************/
+/*!
+    @brief Pack a source or sentence ID into an nmea_id_t. Usable in constant
+    expressions, so nmeaId("GGA") costs nothing at run time.
+    @param s The ID string, e.g. "GP" or "GGA"
+    @param n Character to start from, used for the recursion
+    @return The packed ID, 0 for an empty string
+*/
+/**************************************************************************/
+constexpr nmea_id_t nmeaId(const char *s, uint8_t n = 0) {
+  return (n < 4 && s[n])
+             ? ((nmea_id_t)(uint8_t)s[n] << (8 * (3 - n))) | nmeaId(s, n + 1)
+             : 0;
+}
+
+class Adafruit_GPS;
+
+/// Handler registered with onSentence(), called by parse() once a sentence
+/// has been decoded into the fields of gps
+typedef void (*nmea_sentence_handler_t)(Adafruit_GPS *gps, nmea_id_t sentence);
+#ifdef NMEA_EXTENSIONS
+/// Handler registered with onValue(), called by parse() once a sentence has
+/// updated the data value v, which is gps->val[idx]
+typedef void (*nmea_value_handler_t)(Adafruit_GPS *gps, nmea_index_t idx,
+                                     nmea_datavalue_t *v);
+#endif
+/// Handler registered with onCommand(), called once a command sent with
+/// sendTracked() has been answered or has timed out
+typedef void (*pmtk_command_handler_t)(Adafruit_GPS *gps, uint16_t command,
+                                       pmtk_result_t result);
+/// Handler registered with LOCUS_onRecord(), called by update() for each
+/// record decoded from a LOCUS flash dump
+typedef void (*locus_record_handler_t)(Adafruit_GPS *gps,
+                                       const locus_record_t *record);
+/// Handler registered with onBaudChange(), called by autoBaud() to change
+/// the baud rate of a Stream that the library can't begin() itself
+typedef void (*nmea_baud_handler_t)(Adafruit_GPS *gps, uint32_t baud);
+
 /**************************************************************************/
 /*!
     @brief  The GPS class
@@ -85,6 +315,8 @@ class Adafruit_GPS : public Print {
 public:
   // Adafruit_GPS.cpp
   bool begin(uint32_t baud_or_i2caddr);
+  uint32_t autoBaud(uint32_t fastest = 115200, uint16_t listen = 1200);
+  void onBaudChange(nmea_baud_handler_t handler);
 
 #ifdef USE_SW_SERIAL
   Adafruit_GPS(SoftwareSerial *ser); // Constructor when using SoftwareSerial
@@ -99,16 +331,40 @@ public:
 
   size_t available(void);
   size_t write(uint8_t);
+  size_t write(const uint8_t *buffer, size_t size);
+  using Print::write; // the string flavours
   char read(void);
+  size_t feed(const char *buf, size_t n);
+  size_t readAvailable(void);
+  uint8_t update(void);
   void sendCommand(const char *);
   bool newNMEAreceived();
+  uint8_t pendingSentences(void);
+  uint32_t queueOverruns(void);
+  uint32_t lineOverruns(void);
+  uint32_t lineResyncs(void);
+  uint32_t lineTruncations(void);
+  bool newBinary(void);
+  bool readBinary(uint16_t *id, uint8_t *data, uint16_t *len);
+  void sendBinary(uint16_t id, const uint8_t *data, uint16_t len);
+  uint32_t binaryErrors(void);
   void pause(bool b);
   char *lastNMEA(void);
+  bool lastNMEAvalid(void);
+  uint8_t lastNMEAfields(void);
   bool waitForSentence(const char *wait, uint8_t max = MAXWAITSENTENCE,
                        bool usingInterrupts = false);
+  int8_t sendTracked(const char *cmd, uint16_t timeout = PMTK_TIMEOUT);
+  pmtk_result_t commandResult(int8_t handle);
+  pmtk_result_t waitForCommand(int8_t handle, bool usingInterrupts = false);
+  void onCommand(pmtk_command_handler_t handler);
   bool LOCUS_StartLogger(void);
   bool LOCUS_StopLogger(void);
   bool LOCUS_ReadStatus(void);
+  void LOCUS_StartDump(uint16_t from = 0);
+  bool LOCUS_Sync(void);
+  void LOCUS_onRecord(locus_record_handler_t handler);
+  uint16_t LOCUS_readRecords(locus_record_t *records, uint16_t max);
   bool standby(void);
   bool wakeup(void);
   nmea_float_t secondsSinceFix();
@@ -118,9 +374,25 @@ public:
 
   // NMEA_parse.cpp
   bool parse(char *);
+  bool parse(const char *nmea, size_t len);
   bool check(char *nmea);
+  bool check(const char *nmea, size_t len);
   bool onList(char *nmea, const char **list);
   uint8_t parseHex(char c);
+  char *idString(nmea_id_t id, char *buff);
+  bool onSentence(nmea_id_t sentence, nmea_sentence_handler_t handler);
+  void wantSentences(uint32_t sentences);
+  static bool addSource(const char *source);
+#ifdef NMEA_EXTENSIONS
+  const nmea_satellites_t *satellitesInView(void);
+
+  // NMEA_ais.cpp
+  nmea_vessel_t *findVessel(uint32_t mmsi);
+#endif
+
+  // NMEA_batch.cpp
+  size_t parseBatch(const char *buf, size_t len, nmea_fix_t *fixes,
+                    size_t maxFixes, nmea_batch_stats_t *stats);
 
   // NMEA_build.cpp
 #ifdef NMEA_EXTENSIONS
@@ -144,6 +416,9 @@ public:
   void removeHistory(nmea_index_t idx);
   void showDataValue(nmea_index_t idx, int n = 7);
   bool isCompoundAngle(nmea_index_t idx);
+  bool onValue(nmea_index_t idx, nmea_value_handler_t handler);
+  bool wantValue(nmea_index_t idx, bool wanted = true);
+  void wantAllValues(bool wanted = true);
 #endif
   nmea_float_t boatAngle(nmea_float_t s, nmea_float_t c);
   nmea_float_t compassAngle(nmea_float_t s, nmea_float_t c);
@@ -159,6 +434,10 @@ public:
   char lastSentence[NMEA_MAX_SENTENCE_ID] = {
       0}; ///< the next three letters of the most recent successfully parsed
           ///< sentence, e.g. GLL, RMC
+  nmea_id_t thisSourceId = 0;   ///< thisSource as a code, e.g. nmeaId("GP")
+  nmea_id_t thisSentenceId = 0; ///< thisSentence as a code, e.g. nmeaId("RMC")
+  nmea_id_t lastSourceId = 0;   ///< lastSource as a code
+  nmea_id_t lastSentenceId = 0; ///< lastSentence as a code
 
   uint8_t hour;          ///< GMT hours
   uint8_t minute;        ///< GMT minutes
@@ -213,6 +492,21 @@ public:
   uint8_t LOCUS_speed;    ///< Speed setting
   uint8_t LOCUS_status;   ///< 0: Logging, 1: Stop logging
   uint8_t LOCUS_percent;  ///< Log life used percentage
+  // Progress of a flash dump, updated by read() as the $PMTKLOX lines arrive
+  volatile bool LOCUS_dumping = false;     ///< between $PMTKLOX,0 and ,2
+  volatile uint16_t LOCUS_dumpLines = 0;   ///< lines $PMTKLOX,0 said to expect
+  volatile uint16_t LOCUS_dumpRecords = 0; ///< good records decoded
+  volatile uint16_t LOCUS_dumpErrors = 0;  ///< lines with a bad checksum or
+                                           ///< missed, and bad records
+  volatile uint16_t LOCUS_dumpDropped = 0; ///< records lost because they
+                                           ///< weren't read in time
+  uint16_t LOCUS_synced = 0; ///< records of the log already read, so the
+                             ///< next LOCUS_Sync() starts after them
+
+  char mtkRelease[24] = {0}; ///< firmware release from $PMTK705
+  char mtkModel[12] = {0};   ///< module name from $PMTK705, e.g. PA6H
+  uint8_t mtkSystem = 0; ///< last $PMTK010 system message, 1: startup,
+                         ///< 2: EPO wanted, 3: normal mode
 
 #ifdef NMEA_EXTENSIONS
   // NMEA additional public variables
@@ -229,6 +523,10 @@ public:
   char fromID[NMEA_MAX_WP_ID] = {
       0}; ///< id of waypoint coming from on this segment of the route
 
+  nmea_vessel_t vessels[NMEA_MAX_VESSELS] = {}; ///< AIS vessels heard
+  nmea_vessel_t *lastVessel = NULL; ///< the vessel updated by the last AIS
+                                    ///< message, NULL if none yet
+
   char txtTXT[63] = {0}; ///< text content from most recent TXT sentence
   int txtTot = 0;        ///< total TXT sentences in group
   int txtID = 0;         ///< id of the text message
@@ -242,34 +540,86 @@ private:
   //   bool parseLonDir(char *);
   // NMEA_data.cpp
   void data_init();
+#ifdef NMEA_EXTENSIONS
+  nmea_float_t convertUnit(nmea_float_t v, uint8_t unit, bool toData);
+  static const nmea_schema_t schema[]; ///< fields of the simple sentences
+  // NMEA_build.cpp
+  char *buildSchema(char *p, nmea_id_t sentence);
+#endif
   // NMEA_parse.cpp
-  const char *tokenOnList(char *token, const char **list);
-  bool parseCoord(char *p, nmea_float_t *angleDegrees = NULL,
+  static bool sourceKnown(nmea_id_t source);
+  bool decode(const char *nmea, size_t len);
+#ifdef NMEA_EXTENSIONS
+  bool decodeSchema(void);
+  bool decodeGSV(void);
+  void decodeGSAUsed(void);
+  bool satelliteUsed(char system, uint8_t prn);
+  static char satelliteSystem(nmea_id_t source);
+  // NMEA_ais.cpp
+  bool decodeAIS(void);
+  bool decodeAISMessage(const uint8_t *data, uint16_t bits);
+  nmea_vessel_t *vesselFor(uint32_t mmsi);
+#endif
+  bool decodeMTK(void);
+  void dispatch(void);
+  int sentenceCheck(nmea_id_t id);
+  uint32_t sentenceBit(nmea_id_t id);
+  void nameIds(void);
+  bool indexFields(const char *nmea);
+  const char *field(uint8_t i);
+  const char *nextField(const char *p);
+  bool parseCoord(const char *p, nmea_float_t *angleDegrees = NULL,
                   nmea_float_t *angle = NULL, int32_t *angle_fixed = NULL,
                   char *dir = NULL);
-  char *parseStr(char *buff, char *p, int n);
-  bool parseTime(char *);
-  bool parseFix(char *);
-  bool parseAntenna(char *);
-  bool isEmpty(char *pStart);
-
-  // used by check() for validity tests, room for future expansion
-  const char *sources[7] = {"II", "WI", "GP", "PG",
-                            "GN", "P",  "ZZZ"}; ///< valid source ids
+  char *parseStr(char *buff, const char *p, int n);
+  bool parseTime(const char *);
+  bool scanDecimal(const char *p, uint32_t *whole, uint32_t *frac,
+                   uint8_t decimals);
+  nmea_float_t parseFloat(const char *p);
+  bool parseFix(const char *);
+  bool parseAntenna(const char *);
+  bool isEmpty(const char *pStart);
+  const char *fieldEnd = NULL; ///< the * of the sentence being parsed
+  const char *fieldBase = NULL; ///< start of the sentence being parsed
+  uint8_t fieldStart[NMEA_MAX_FIELDS]; ///< offset of each field from fieldBase
+  uint8_t fieldCount = 0;              ///< number of fields indexed
+  const char *idStart = NULL;  ///< sentence ID in the sentence being checked
+  uint8_t idLen = 0;           ///< length of the sentence ID at idStart
+  struct {
+    nmea_id_t sentence;              ///< sentence to handle, 0 for all
+    nmea_sentence_handler_t handler; ///< function to call, NULL if unused
+  } sentenceHandlers[NMEA_MAX_HANDLERS] = {}; ///< set with onSentence()
 #ifdef NMEA_EXTENSIONS
-  const char *sentences_parsed[21] = {"GGA", "GLL", "GSA", "RMC", "DBT", "HDM",
-                                      "HDT", "MDA", "MTW", "MWV", "RMB", "TOP",
-                                      "TXT", "VHW", "VLW", "VPW", "VWR", "WCV",
-                                      "XTE", "ZZZ"}; ///< parseable sentence ids
-  const char *sentences_known[15] = {
-      "APB", "DPT", "GSV", "HDG", "MWD", "ROT",
-      "RPM", "RSA", "VDR", "VTG", "ZDA", "ZZZ"}; ///< known, but not parseable
-#else // make the lists short to save memory
-  const char *sentences_parsed[6] = {"GGA", "GLL", "GSA", "RMC",
-                                     "TOP", "ZZZ"}; ///< parseable sentence ids
-  const char *sentences_known[4] = {"DBT", "HDM", "HDT",
-                                    "ZZZ"}; ///< known, but not parseable
+  nmea_value_handler_t valueHandlers[NMEA_MAX_INDEX] = {}; ///< from onValue()
+  uint8_t valUpdated[(NMEA_MAX_INDEX + 7) / 8] = {}; ///< bit per val[] set
+                                                     ///< by this sentence
+  uint8_t valWanted[(NMEA_MAX_INDEX + 7) / 8]; ///< bit per val[] to update
+  nmea_satellites_t satTable[2] = {}; ///< front one complete, back one for
+                                      ///< the GSV group being assembled
+  uint8_t satFront = 0; ///< which of satTable is complete, flipped atomically
+  uint8_t satPart = 0;  ///< GSV part of the group parsed last, 0 if none
+  char satSystem = 0;   ///< satellite system of the GSV group being assembled
+  uint8_t usedPrn[NMEA_MAX_SATELLITES];  ///< PRNs from the last GSA sentences
+  char usedSystem[NMEA_MAX_SATELLITES];  ///< their satellite systems
+  uint8_t usedCount = 0;                 ///< number of usedPrn
+  uint32_t usedTime = 0; ///< fix time at the last GSA, ms since midnight
+  struct {
+    uint8_t total;    ///< fragments in the message, 0 if the slot is free
+    uint8_t next;     ///< fragment expected next
+    char seq;         ///< sequential message ID shared by the fragments
+    char channel;     ///< radio channel, A or B
+    uint16_t bits;    ///< message bits so far
+    uint32_t started; ///< millis() when the first fragment arrived
+    uint8_t data[NMEA_AIS_MAXBYTES]; ///< message bits, first in the top bit
+  } aisParts[NMEA_AIS_FRAGMENTS] = {}; ///< multipart AIS being reassembled
 #endif
+  uint32_t sentenceMask = NMEA_SENTENCE_MASK; ///< sentences to decode
+
+  // used by check() for validity tests. The built in talkers are in a table
+  // shared by all objects in NMEA_parse.cpp, and the parseable and known
+  // sentences are the cases in sentenceCheck().
+  static nmea_id_t
+      extraSources[NMEA_MAX_EXTRA_SOURCES]; ///< talkers from addSource()
 
   // Make all of these times far in the past by setting them near the middle of
   // the millis() range. Timing assumes that sentences are parsed promptly.
@@ -282,9 +632,29 @@ private:
       2000000000L; ///< millis() when last full sentence received
   uint32_t sentTime = 2000000000L; ///< millis() when first character of last
                                    ///< full sentence received
+  uint32_t firstChar = 0; ///< millis() when first character of the sentence
+                          ///< currently being received arrived, 0 if none
   bool paused;
 
   uint8_t parseResponse(char *response);
+  bool fillI2CBuffer(void);
+  bool fillSPIBuffer(void);
+  uint8_t frameChar(char c, uint32_t t);
+  void scanLine(uint8_t from, uint8_t to);
+  void newLine(uint32_t t);
+  bool setReplyAside(void);
+  void frameBinary(uint8_t c);
+  // NMEA_locus.cpp
+  void locusChar(char c);
+  void locusByte(uint8_t b);
+  void locusEnd(void);
+  void flushNMEA(void);
+  void switchBaud(uint32_t baud);
+  bool setPortBaud(uint32_t baud);
+  bool hearSentence(uint16_t ms);
+  void commandAnswered(uint16_t command, nmea_id_t reply, uint8_t result);
+  void commandDone(uint8_t slot, uint8_t result);
+  void checkCommands(void);
 #ifdef USE_SW_SERIAL
   SoftwareSerial *gpsSwSerial;
 #endif
@@ -294,22 +664,116 @@ private:
   TwoWire *gpsI2C;
   SPIClass *gpsSPI;
   int8_t gpsSPI_cs = -1;
+  nmea_baud_handler_t baudHandler = NULL; ///< set with onBaudChange()
   SPISettings gpsSPI_settings =
       SPISettings(1000000, MSBFIRST, SPI_MODE0); // default
-  char _spibuffer[GPS_MAX_SPI_TRANSFER]; // for when we write data, we need to
-                                         // read it too!
+  char _spibuffer[GPS_MAX_SPI_TRANSFER]; // block read from the module, and
+                                         // what read() serves characters from
   uint8_t _i2caddr;
   char _i2cbuffer[GPS_MAX_I2C_TRANSFER];
-  int8_t _buff_max = -1, _buff_idx = 0;
+  int16_t _buff_max = -1, _buff_idx = 0;
+  uint32_t _i2cNextPoll = 0;   ///< millis() when the next I2C poll is due
+  uint16_t _i2cBackoff = 0;    ///< ms to wait after an empty I2C poll
+  uint32_t _i2cEpochStart = 0; ///< millis() when the last burst started
+  uint32_t _i2cEpoch = 0;      ///< ms between bursts, 0 until learned
   char last_char = 0;
 
-  volatile char line1[MAXLINELENGTH]; ///< We double buffer: read one line in
-                                      ///< and leave one for the main program
-  volatile char line2[MAXLINELENGTH]; ///< Second buffer
+  // The sentence queue is a single producer, single consumer ring. read(),
+  // feed() and readAvailable() are the producer and may run in an interrupt.
+  // newNMEAreceived(), lastNMEA() and pendingSentences() are the consumer.
+  // Each side only writes its own index, and publishes it with release
+  // ordering after the slot contents are complete, so neither side ever has
+  // to disable interrupts or sees a half written sentence.
+  volatile char lines[NMEA_QUEUE_DEPTH]
+                    [MAXLINELENGTH]; ///< Ring of sentence slots: read one line
+                                     ///< in while the main program works
+                                     ///< through the ones already received
+  nmea_line_t qInfo[NMEA_QUEUE_DEPTH]; ///< framing details for each slot
+  nmea_line_t lastInfo = {0, 0, 0, 0, false}; ///< details for lastline
+  uint8_t rxSum = 0;         ///< running XOR of the current line after the $
+  uint8_t rxSumAtStar = 0;   ///< XOR up to the last '*' in the current line
+  uint8_t rxStar = 0;        ///< index of the last '*' in the current line
+  uint8_t rxCommas = 0;      ///< commas so far in the current line
+  uint8_t rxCommasAtStar = 0; ///< commas before the last '*'
+  enum {
+    RX_HUNT,    ///< between sentences, waiting for a $ or !
+    RX_FRAME,   ///< assembling a sentence
+    RX_DISCARD, ///< throwing away an overlong line until the next $ or !
+    RX_BINARY,  ///< assembling an MTK binary packet
+    RX_LOCUS    ///< decoding a $PMTKLOX line, too long to queue
+  } rxState = RX_HUNT;      ///< state of the framing in read()
+  bool rxSkipped = false;   ///< stray characters seen while hunting
+  uint32_t rxOverruns = 0;  ///< lines too long for MAXLINELENGTH
+  uint32_t rxResyncs = 0;   ///< hunts for a $ or ! after stray characters
+  uint32_t rxTruncated = 0; ///< sentences cut short by the next $ or !
+
+  // MTK binary packets are assembled in binRx by read(), then copied to
+  // binPacket once the last one has been taken by readBinary(), with the
+  // same single producer, single consumer rules as the sentence queue.
+  uint8_t binRx[MTK_BINARY_MAXLENGTH];     ///< packet being assembled
+  uint8_t binPacket[MTK_BINARY_MAXLENGTH]; ///< last complete packet
+  uint16_t binIdx = 0;    ///< bytes so far in binRx
+  bool binReady = false;  ///< binPacket holds a packet not yet read
+  volatile bool binExpected = false; ///< sendBinary() has been used, so the
+                                     ///< module may be answering in binary
+  uint32_t binErrors = 0; ///< packets lost to a bad length or checksum, or
+                          ///< to one not yet read
+
+  // Commands from sendTracked() wait here for the $PMTK001 or reply sentence
+  // that parse() finds, matched by command number, oldest first.
+  struct {
+    uint16_t command; ///< PMTK command number, 0 if the slot is free
+    uint16_t timeout; ///< milliseconds to wait for the answer
+    nmea_id_t reply;  ///< $PMTK message that answers a query, 0 if none
+    uint32_t sent;    ///< millis() when the command was sent
+    uint8_t result;   ///< pmtk_result_t, PMTK_PENDING until answered
+  } commands[PMTK_MAX_COMMANDS] = {}; ///< commands from sendTracked()
+  pmtk_command_handler_t commandHandler = NULL; ///< set with onCommand()
+  int8_t commandWaited = -1; ///< handle waitForCommand() is waiting on
+  volatile uint8_t commandsPending = 0; ///< tracked commands not answered
+
+  // While commands are pending, read() sets the $PMTK lines aside here rather
+  // than in the sentence queue, so a queue full of other sentences can't lose
+  // an answer, and checkCommands() parses them. Each slot is handed over by
+  // its replyReady flag, with the same single producer, single consumer
+  // rules as the sentence queue.
+  char replies[PMTK_REPLY_SLOTS][PMTK_REPLY_LENGTH]; ///< answers set aside
+  volatile bool replyReady[PMTK_REPLY_SLOTS] = {}; ///< slot holds an answer
+
+  // $PMTKLOX lines from a LOCUS dump are too long for the sentence queue, so
+  // read() decodes them a character at a time into records in lxRing, with
+  // the same single producer, single consumer rules. The records from a
+  // line are only published once the line's checksum has been checked.
+  locus_record_t lxRing[LOCUS_RECORD_QUEUE]; ///< decoded records
+  volatile uint8_t lxHead = 0; ///< end of the published records, written
+                               ///< by the producer
+  volatile uint8_t lxTail = 0; ///< oldest unread record, written by the
+                               ///< consumer
+  uint8_t lxPending = 0; ///< end of the records from the current line
+  uint8_t lxRec[16];     ///< record being assembled
+  uint8_t lxRecIdx = 0;  ///< bytes so far in lxRec
+  uint8_t lxField = 0;   ///< field of the line being decoded
+  uint8_t lxType = 0;    ///< 0 start, 1 data or 2 end
+  uint8_t lxStar = 0;    ///< characters since the *, 0 if none yet
+  uint8_t lxCheck = 0;   ///< checksum from after the *
+  uint8_t lxByte = 0;    ///< byte being assembled from hex digits
+  bool lxHalf = false;   ///< lxByte has its first hex digit
+  bool lxBad = false;    ///< something other than hex in the data
+  uint16_t lxLine = 0;   ///< line number, or line count for type 0
+  uint16_t lxNext = 0;   ///< line number expected next
+  uint32_t lxOffset = 0; ///< flash address of the next byte
+  uint32_t lxFrom = 0;   ///< flash address of the first record wanted
+  bool lxSkip = false;   ///< line is all before lxFrom, so not decoded
+  locus_record_handler_t locusHandler = NULL; ///< set with LOCUS_onRecord()
+
   volatile uint8_t lineidx = 0; ///< our index into filling the current line
-  volatile char *currentline;   ///< Pointer to current line buffer
-  volatile char *lastline;      ///< Pointer to previous line buffer
-  volatile bool recvdflag;      ///< Received flag
+  volatile uint8_t qHead = 0;   ///< slot being filled, written by producer
+  volatile uint8_t qTail = 0;   ///< oldest slot still in use, written by
+                                ///< consumer
+  bool qHeld = false; ///< consumer is still using the line at qTail
+  volatile uint32_t qOverruns = 0; ///< sentences dropped on a full queue
+  volatile char *currentline;      ///< Pointer to current line buffer
+  volatile char *lastline;         ///< Pointer to previous line buffer
   volatile bool inStandbyMode;  ///< In standby flag
 };
 /**************************************************************************/
@@ -51,6 +51,10 @@
 #define PMTK_SET_BAUD_57600 "$PMTK251,57600*2C"   ///<  57600 bps
 #define PMTK_SET_BAUD_9600 "$PMTK251,9600*17"     ///<   9600 bps
 
+#define MTK_BINARY_ACK 1 ///< MTK binary packet ID of an acknowledgement
+#define MTK_BINARY_SET_OUTPUT                                                  \
+  253 ///< MTK binary packet ID to choose binary or NMEA output and baud rate
+
 #define PMTK_SET_NMEA_OUTPUT_GLLONLY                                           \
   "$PMTK314,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*29" ///< turn on only the
                                                       ///< GPGLL sentence
@@ -90,6 +94,8 @@
   "$PMTK001,185,3*3C" ///< Acknowledge the start or stop command
 #define PMTK_LOCUS_QUERY_STATUS "$PMTK183*38"  ///< Query the logging status
 #define PMTK_LOCUS_ERASE_FLASH "$PMTK184,1*22" ///< Erase the log flash data
+#define PMTK_LOCUS_DUMP                                                        \
+  "$PMTK622,1*29" ///< Dump the log flash data as $PMTKLOX lines
 #define LOCUS_OVERLAP                                                          \
   0 ///< If flash is full, log will overwrite old data with new logs
 #define LOCUS_FULLSTOP 1 ///< If flash is full, logging will stop
@@ -112,5 +118,175 @@
 
 #define MAXWAITSENTENCE                                                        \
   10 ///< how long to wait when we're looking for a response
+#define PMTK_TIMEOUT                                                           \
+  1000 ///< default milliseconds to wait for a tracked command to be answered
+
+#ifdef __cplusplus
+#include <stdint.h>
+
+/**************************************************************************/
+/*
+ The compiler can write any PMTK command, checksum and all, from numbers
+ given as template arguments, so custom rates and output masks cost no more
+ than the strings above and need no addChecksum() at run time, e.g.
+
+   GPS.sendCommand(pmtkOutput<0, 1, 0, 1, 1, 5>()); // RMC, GGA, GSA, and
+                                                    // GSV every 5th fix
+   GPS.sendCommand(pmtkCommand<220, 250>());       // $PMTK220,250*29
+
+ The string is built as a pack of template char arguments, with the
+ checksum worked out by a constexpr function of the pack.
+ */
+
+/// Characters of a command being built, and the finished string
+template <char... c> struct pmtk_chars {
+  static constexpr char str[sizeof...(c) + 1] = {c..., 0}; ///< the string
+};
+template <char... c> constexpr char pmtk_chars<c...>::str[sizeof...(c) + 1];
+
+/// Join two pmtk_chars
+template <class A, class B> struct pmtk_cat;
+/// Join two pmtk_chars
+template <char... a, char... b>
+struct pmtk_cat<pmtk_chars<a...>, pmtk_chars<b...>> {
+  typedef pmtk_chars<a..., b...> type; ///< the joined characters
+};
+
+/// The decimal digits of n followed by the characters in tail
+template <uint32_t n, char... tail>
+struct pmtk_digits : pmtk_digits<n / 10, (char)('0' + n % 10), tail...> {};
+/// The decimal digits of n followed by the characters in tail
+template <char... tail> struct pmtk_digits<0, tail...> {
+  typedef pmtk_chars<tail...> type; ///< the digits
+};
+
+/// A comma before each field value
+template <uint32_t... f> struct pmtk_fields {
+  typedef pmtk_chars<> type; ///< no fields
+};
+/// A comma before each field value
+template <uint32_t f, uint32_t... rest> struct pmtk_fields<f, rest...> {
+  typedef typename pmtk_cat<
+      typename pmtk_cat<
+          pmtk_chars<','>,
+          typename pmtk_digits<f / 10, (char)('0' + f % 10)>::type>::type,
+      typename pmtk_fields<rest...>::type>::type type; ///< the fields
+};
+
+/**************************************************************************/
+/*!
+    @brief Exclusive or of characters, the NMEA checksum.
+    @return The checksum of no characters, 0
+*/
+/**************************************************************************/
+constexpr uint8_t pmtkChecksum() { return 0; }
+
+/**************************************************************************/
+/*!
+    @brief Exclusive or of characters, the NMEA checksum.
+    @param c The first character
+    @param rest The rest of them
+    @return The checksum
+*/
+/**************************************************************************/
+template <typename... T>
+constexpr uint8_t pmtkChecksum(char c, T... rest) {
+  return (uint8_t)c ^ pmtkChecksum(rest...);
+}
+
+/**************************************************************************/
+/*!
+    @brief The upper case hex digit for a checksum nibble.
+    @param v The nibble, 0 to 15
+    @return '0' to '9' or 'A' to 'F'
+*/
+/**************************************************************************/
+constexpr char pmtkHexDigit(uint8_t v) {
+  return v < 10 ? '0' + v : 'A' + v - 10;
+}
+
+/// The body of a sentence between $ and *, wrapped and checksummed
+template <class Body> struct pmtk_sentence;
+/// The body of a sentence between $ and *, wrapped and checksummed
+template <char... b> struct pmtk_sentence<pmtk_chars<b...>> {
+  typedef pmtk_chars<'$', b..., '*', pmtkHexDigit(pmtkChecksum(b...) >> 4),
+                     pmtkHexDigit(pmtkChecksum(b...) & 15)>
+      type; ///< the complete sentence
+};
+
+/**************************************************************************/
+/*!
+    @brief Any PMTK command, built at compile time.
+    @tparam command The three digit command number, e.g. 220
+    @tparam fields The values of the fields after it, if any
+    @return The command, e.g. "$PMTK220,100*2F" for pmtkCommand<220, 100>()
+*/
+/**************************************************************************/
+template <uint16_t command, uint32_t... fields>
+constexpr const char *pmtkCommand() {
+  return pmtk_sentence<typename pmtk_cat<
+      pmtk_chars<'P', 'M', 'T', 'K', (char)('0' + command / 100 % 10),
+                 (char)('0' + command / 10 % 10), (char)('0' + command % 10)>,
+      typename pmtk_fields<fields...>::type>::type>::type::str;
+}
+
+/**************************************************************************/
+/*!
+    @brief PMTK220, how often the sentences are sent.
+    @tparam ms Milliseconds between updates, 100 to 10000
+    @return The command
+*/
+/**************************************************************************/
+template <uint32_t ms> constexpr const char *pmtkUpdateRate() {
+  static_assert(ms >= 100 && ms <= 10000, "PMTK220 takes 100 to 10000 ms");
+  return pmtkCommand<220, ms>();
+}
+
+/**************************************************************************/
+/*!
+    @brief PMTK300, how often the position is fixed.
+    @tparam ms Milliseconds between fixes, 200 to 10000
+    @return The command
+*/
+/**************************************************************************/
+template <uint32_t ms> constexpr const char *pmtkFixInterval() {
+  static_assert(ms >= 200 && ms <= 10000, "PMTK300 takes 200 to 10000 ms");
+  return pmtkCommand<300, ms, 0, 0, 0, 0>();
+}
+
+/**************************************************************************/
+/*!
+    @brief PMTK251, the baud rate of the serial port.
+    @tparam baud The new rate, e.g. 57600, or 0 for the module's default
+    @return The command
+*/
+/**************************************************************************/
+template <uint32_t baud> constexpr const char *pmtkBaud() {
+  return pmtkCommand<251, baud>();
+}
+
+/**************************************************************************/
+/*!
+    @brief PMTK314, which sentences are sent and how often. Each is sent
+    every that many fixes, 0 to 5, where 0 turns it off.
+    @tparam gll GLL
+    @tparam rmc RMC
+    @tparam vtg VTG
+    @tparam gga GGA
+    @tparam gsa GSA
+    @tparam gsv GSV
+    @return The command
+*/
+/**************************************************************************/
+template <uint8_t gll, uint8_t rmc, uint8_t vtg, uint8_t gga, uint8_t gsa,
+          uint8_t gsv>
+constexpr const char *pmtkOutput() {
+  static_assert(gll <= 5 && rmc <= 5 && vtg <= 5 && gga <= 5 && gsa <= 5 &&
+                    gsv <= 5,
+                "PMTK314 sends each sentence every 0 to 5 fixes");
+  return pmtkCommand<314, gll, rmc, vtg, gga, gsa, gsv, 0, 0, 0, 0, 0, 0, 0, 0,
+                     0, 0, 0, 0, 0>();
+}
+#endif // __cplusplus
 /**************************************************************************/
 #endif
@@ -0,0 +1,316 @@
+/**************************************************************************/
+/*!
+  @file NMEA_ais.cpp
+
+  Decoding of the AIS messages that an AIS receiver sends wrapped in !AIVDM
+  sentences for other vessels and !AIVDO sentences for our own. The common
+  position reports (types 1, 2, 3 and 18) and static data reports (types 5
+  and 24) are kept in a small table of vessels, and the vessel heard from
+  longest ago makes way for a new one when the table is full. See
+  https://gpsd.gitlab.io/gpsd/AIVDM.html for the message layouts.
+
+  Adafruit invests time and resources providing this open source code,
+  please support Adafruit and open-source hardware by purchasing
+  products from Adafruit!
+
+  @copyright BSD license, check license.txt for more information
+  All text above must be included in any redistribution
+*/
+/**************************************************************************/
+
+#include <Adafruit_GPS.h>
+
+#ifdef NMEA_EXTENSIONS
+// The 6 bit value of each payload character from '0' to 'w', 0xFF for the
+// characters in between that the armoring doesn't use.
+static const uint8_t aisArmor[] PROGMEM = {
+    0,   1,   2,   3,   4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,
+    15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,
+    30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  255, 255, 255, 255, 255,
+    255, 255, 255, 40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,
+    52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63};
+
+/**************************************************************************/
+/*!
+    @brief Pull an unsigned number out of an AIS message.
+    @param data The message bits, first in the top bit of data[0]
+    @param start Number of the first bit
+    @param len Number of bits, up to 32
+    @return The number
+*/
+/**************************************************************************/
+static uint32_t aisBits(const uint8_t *data, uint16_t start, uint8_t len) {
+  uint32_t v = 0;
+  for (uint16_t i = start; i < start + len; i++)
+    v = (v << 1) | ((data[i >> 3] >> (7 - (i & 7))) & 1);
+  return v;
+}
+
+/**************************************************************************/
+/*!
+    @brief Pull a two's complement signed number out of an AIS message.
+    @param data The message bits
+    @param start Number of the first bit
+    @param len Number of bits, up to 32
+    @return The number
+*/
+/**************************************************************************/
+static int32_t aisSigned(const uint8_t *data, uint16_t start, uint8_t len) {
+  uint32_t v = aisBits(data, start, len);
+  if (len < 32 && (v & (1UL << (len - 1))))
+    v |= ~0UL << len; // extend the sign
+  return (int32_t)v;
+}
+
+/**************************************************************************/
+/*!
+    @brief Pull a 6 bit text field out of an AIS message, dropping the @
+    padding and trailing spaces.
+    @param buff Buffer for the text, n + 1 characters
+    @param data The message bits
+    @param start Number of the first bit
+    @param n Number of characters
+*/
+/**************************************************************************/
+static void aisText(char *buff, const uint8_t *data, uint16_t start,
+                    uint8_t n) {
+  uint8_t len = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t c = aisBits(data, start + 6 * i, 6);
+    if (c == 0)
+      break; // @ ends the text
+    buff[len++] = c < 32 ? c + 64 : c;
+  }
+  while (len > 0 && buff[len - 1] == ' ')
+    len--;
+  buff[len] = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Turn an AIS latitude or longitude in 1/10000 minute into the
+    same fixed point form as latitude_fixed.
+    @param v The AIS position
+    @return Position in 1/10000000 degree
+*/
+/**************************************************************************/
+static int32_t aisFixed(int32_t v) { return (int32_t)((int64_t)v * 50 / 3); }
+
+/**************************************************************************/
+/*!
+    @brief Decode an !AIVDM or !AIVDO sentence, adding its payload to the
+    message it belongs to. Single sentence messages are decoded straight
+    away. Fragments of longer ones wait in a pool of NMEA_AIS_FRAGMENTS
+    slots, matched by sequential message ID and channel, until the last one
+    arrives. A fragment out of order throws its message away, and a new
+    message takes the slot of the oldest unfinished one if the pool is full.
+    Messages of types that aren't decoded don't take a slot.
+    @return true if a complete message updated a vessel, false if not
+*/
+/**************************************************************************/
+bool Adafruit_GPS::decodeAIS(void) {
+  //       1 2 3 4 5    6
+  //       | | | | |    |
+  //!AIVDM,x,x,x,a,s--s,x*hh
+  // 1) number of fragments 2) fragment number 3) sequential message ID for
+  // multipart messages 4) radio channel 5) 6 bit armored payload 6) number
+  // of fill bits at the end of the payload
+  uint8_t total = atoi(field(1));
+  uint8_t part = atoi(field(2));
+  if (part == 0 || part > total)
+    return false;
+  const char *p = field(3);
+  char seq = isEmpty(p) ? 0 : *p;
+  p = field(4);
+  char channel = isEmpty(p) ? 0 : *p;
+  p = field(5);
+  if (isEmpty(p))
+    return false;
+
+  uint8_t single[NMEA_AIS_MAXBYTES];
+  uint8_t *data = single;
+  uint16_t bits = 0;
+  uint8_t slot = NMEA_AIS_FRAGMENTS;
+  if (part == 1) {
+    uint8_t type = *p - '0'; // a quick look before using up a slot
+    if (type != 1 && type != 2 && type != 3 && type != 5 && type != 18 &&
+        type != 24)
+      return false;
+    if (total > 1) {
+      slot = 0; // the same message again, a free slot or the oldest one
+      for (uint8_t i = 0; i < NMEA_AIS_FRAGMENTS; i++) {
+        if (aisParts[i].total &&
+            (aisParts[i].seq != seq || aisParts[i].channel != channel)) {
+          uint32_t now = millis();
+          if (aisParts[slot].total &&
+              now - aisParts[i].started > now - aisParts[slot].started)
+            slot = i;
+          continue;
+        }
+        slot = i;
+        break;
+      }
+      aisParts[slot].total = total;
+      aisParts[slot].seq = seq;
+      aisParts[slot].channel = channel;
+      aisParts[slot].started = millis();
+      aisParts[slot].bits = 0;
+      data = aisParts[slot].data;
+    }
+    memset(data, 0, NMEA_AIS_MAXBYTES);
+  } else {
+    for (slot = 0; slot < NMEA_AIS_FRAGMENTS; slot++)
+      if (aisParts[slot].total == total && aisParts[slot].seq == seq &&
+          aisParts[slot].channel == channel)
+        break;
+    if (slot == NMEA_AIS_FRAGMENTS)
+      return false; // missed the start of it
+    if (aisParts[slot].next != part) {
+      aisParts[slot].total = 0; // lost a fragment, so give up on it
+      return false;
+    }
+    data = aisParts[slot].data;
+    bits = aisParts[slot].bits;
+  }
+
+  // unpack the payload, 6 bits a character, straight into the message
+  for (; p < fieldEnd && *p != ','; p++) {
+    uint8_t c = *p - '0';
+    uint8_t v = c < sizeof(aisArmor) ? pgm_read_byte(&aisArmor[c]) : 0xFF;
+    if (v == 0xFF || bits + 6 > NMEA_AIS_MAXBYTES * 8) {
+      if (slot < NMEA_AIS_FRAGMENTS)
+        aisParts[slot].total = 0;
+      return false; // not armored, or too long for any we decode
+    }
+    uint8_t shift = bits & 7;
+    data[bits >> 3] |= (v << 2) >> shift;
+    if (shift > 2)
+      data[(bits >> 3) + 1] |= (uint8_t)(v << (10 - shift));
+    bits += 6;
+  }
+
+  if (part < total) {
+    aisParts[slot].bits = bits;
+    aisParts[slot].next = part + 1;
+    return false;
+  }
+  if (slot < NMEA_AIS_FRAGMENTS)
+    aisParts[slot].total = 0; // done with the slot
+  uint8_t fill = atoi(field(6));
+  return decodeAISMessage(data, bits > fill ? bits - fill : 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief Decode a complete AIS message into the vessel table.
+    @param data The message bits, first in the top bit of data[0]
+    @param bits Number of bits in the message
+    @return true if it was a type that is decoded and long enough
+*/
+/**************************************************************************/
+bool Adafruit_GPS::decodeAISMessage(const uint8_t *data, uint16_t bits) {
+  if (bits < 40)
+    return false;
+  uint8_t type = aisBits(data, 0, 6);
+  uint32_t mmsi = aisBits(data, 8, 30);
+  nmea_vessel_t *v;
+  switch (type) {
+  case 1: // class A position reports
+  case 2:
+  case 3:
+    if (bits < 137)
+      return false;
+    v = vesselFor(mmsi);
+    v->status = aisBits(data, 38, 4);
+    v->sog = aisBits(data, 50, 10);
+    v->longitude_fixed = aisFixed(aisSigned(data, 61, 28));
+    v->latitude_fixed = aisFixed(aisSigned(data, 89, 27));
+    v->cog = aisBits(data, 116, 12);
+    v->heading = aisBits(data, 128, 9);
+    break;
+
+  case 18: // class B position report
+    if (bits < 133)
+      return false;
+    v = vesselFor(mmsi);
+    v->sog = aisBits(data, 46, 10);
+    v->longitude_fixed = aisFixed(aisSigned(data, 57, 28));
+    v->latitude_fixed = aisFixed(aisSigned(data, 85, 27));
+    v->cog = aisBits(data, 112, 12);
+    v->heading = aisBits(data, 124, 9);
+    break;
+
+  case 5: // class A static and voyage related data
+    if (bits < 240)
+      return false;
+    v = vesselFor(mmsi);
+    aisText(v->callsign, data, 70, 7);
+    aisText(v->name, data, 112, 20);
+    v->shipType = aisBits(data, 232, 8);
+    break;
+
+  case 24: // class B static data, in two parts
+    if (aisBits(data, 38, 2) == 0) {
+      if (bits < 160)
+        return false;
+      v = vesselFor(mmsi);
+      aisText(v->name, data, 40, 20);
+    } else {
+      if (bits < 132)
+        return false;
+      v = vesselFor(mmsi);
+      v->shipType = aisBits(data, 40, 8);
+      aisText(v->callsign, data, 90, 7);
+    }
+    break;
+
+  default:
+    return false;
+  }
+  v->lastHeard = millis();
+  lastVessel = v;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Find the entry for a vessel in the table, making one if it isn't
+    there by reusing a free entry or the one heard from longest ago.
+    @param mmsi The vessel's MMSI
+    @return Pointer to the entry
+*/
+/**************************************************************************/
+nmea_vessel_t *Adafruit_GPS::vesselFor(uint32_t mmsi) {
+  nmea_vessel_t *v = findVessel(mmsi);
+  if (v)
+    return v;
+  v = &vessels[0];
+  for (uint8_t i = 0; i < NMEA_MAX_VESSELS && v->mmsi; i++)
+    if (!vessels[i].mmsi ||
+        millis() - vessels[i].lastHeard > millis() - v->lastHeard)
+      v = &vessels[i];
+  memset(v, 0, sizeof(*v));
+  v->mmsi = mmsi;
+  v->latitude_fixed = 910000000; // the AIS values for not available
+  v->longitude_fixed = 1810000000;
+  v->sog = 1023;
+  v->cog = 3600;
+  v->heading = 511;
+  v->status = 15;
+  return v;
+}
+
+/**************************************************************************/
+/*!
+    @brief Look up a vessel that has been heard on AIS.
+    @param mmsi The vessel's MMSI
+    @return Pointer to its entry in vessels[], or NULL if it isn't there
+*/
+/**************************************************************************/
+nmea_vessel_t *Adafruit_GPS::findVessel(uint32_t mmsi) {
+  for (uint8_t i = 0; i < NMEA_MAX_VESSELS; i++)
+    if (vessels[i].mmsi == mmsi && mmsi)
+      return &vessels[i];
+  return NULL;
+}
+#endif // NMEA_EXTENSIONS
@@ -0,0 +1,97 @@
+/**************************************************************************/
+/*!
+  @file NMEA_batch.cpp
+
+  Parsing of whole logs at once, e.g. a GPSLOG00.TXT from the shield_sdlog
+  example read into memory or memory mapped on a PC. The sentences are
+  parsed in place with the same code as parse(), and the GGA, RMC and GLL
+  sentences are gathered into compact fix records.
+
+  Adafruit invests time and resources providing this open source code,
+  please support Adafruit and open-source hardware by purchasing
+  products from Adafruit!
+
+  @copyright BSD license, check license.txt for more information
+  All text above must be included in any redistribution
+*/
+/**************************************************************************/
+
+#include <Adafruit_GPS.h>
+
+/**************************************************************************/
+/*!
+    @brief Parse every whole line in a buffer of NMEA sentences, e.g.
+
+      nmea_batch_stats_t stats = {};
+      size_t n = GPS.parseBatch(log, logLength, fixes, 1000, &stats);
+
+    Each line is checked and decoded in place, exactly as parse() would, so
+    the object's variables end up as if the lines had been parsed one by
+    one. Handlers from onSentence() and onValue() are not called. Each time
+    a GGA, RMC or GLL sentence is decoded, the current fix is copied into
+    the record for its time, starting a new record when the time changes.
+    wantSentences() and, with NMEA_EXTENSIONS, wantAllValues(false) make it
+    quicker by skipping the sentences and the smoothing a log doesn't need.
+
+    A last line without a '\n' is left alone, and stats->bytes says where
+    it starts, so a file can be fed in chunks by carrying the rest over to
+    the next call.
+    @param buf Pointer to the sentences, one per line, CR LF or just LF
+    @param len Number of characters in buf
+    @param fixes Array to fill with fix records, may be NULL to only count
+    @param maxFixes Number of records that fit in fixes
+    @param stats Counts to add to, zeroed by the caller before the first call
+    @return Number of records written to fixes
+*/
+/**************************************************************************/
+size_t Adafruit_GPS::parseBatch(const char *buf, size_t len, nmea_fix_t *fixes,
+                                size_t maxFixes, nmea_batch_stats_t *stats) {
+  size_t n = 0;
+  const char *end = buf + len;
+  const char *line = buf;
+  const char *eol;
+  while ((eol = (const char *)memchr(line, '\n', end - line)) != NULL) {
+    const char *start = line;
+    line = eol + 1;
+    if (eol > start && eol[-1] == '\r')
+      eol--;
+    if (eol == start)
+      continue; // blank
+    stats->lines++;
+    if (!decode(start, eol - start)) {
+      if (thisCheck < NMEA_HAS_DOLLAR + NMEA_HAS_CHECKSUM)
+        stats->rejected++;
+      else
+        stats->skipped++;
+      continue;
+    }
+    stats->parsed++;
+    uint32_t bit = sentenceBit(thisSentenceId);
+    stats->type[__builtin_ctzl(bit)]++;
+    if (!(bit & (NMEA_MASK_GGA | NMEA_MASK_RMC | NMEA_MASK_GLL)))
+      continue;
+    uint32_t t = ((hour * 100UL + minute) * 100 + seconds) * 1000;
+    t += milliseconds;
+    if (n == 0 || fixes[n - 1].time != t) {
+      if (n == maxFixes || !fixes) {
+        stats->dropped++;
+        continue;
+      }
+      n++;
+    }
+    nmea_fix_t *f = &fixes[n - 1];
+    f->time = t;
+    f->date = day ? day * 10000UL + month * 100 + year : 0;
+    f->latitude_fixed = latitude_fixed;
+    f->longitude_fixed = longitude_fixed;
+    f->altitude = altitude;
+    f->speed = speed;
+    f->angle = angle;
+    f->HDOP = HDOP;
+    f->fixquality = fixquality;
+    f->satellites = satellites;
+    f->fix = fix;
+  }
+  stats->bytes += line - buf;
+  return n;
+}
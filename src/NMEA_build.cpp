@@ -79,12 +79,14 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
   p += strlen(thisSentence);
   *p = ',';
   p += 1; // Now $XXSSS, and need to add argument fields
-  // This may look inefficient, but an M0 will get down the list in about 1 us /
-  // strcmp()! Put the GPS sentences from Adafruit_GPS at the top to make
-  // pruning excess code easier. Otherwise, keep them alphabetical for ease of
-  // reading.
-
-  if (!strcmp(thisSentence, "GGA")) { //************************************GGA
+  // A switch on the packed ID, so where a sentence sits in the list doesn't
+  // matter. Put the GPS sentences from Adafruit_GPS at the top to make pruning
+  // excess code easier. Otherwise, keep them alphabetical for ease of reading.
+  // Sentences that are only data values and their units are rows in the
+  // schema table in NMEA_data.cpp instead, and are built by the default.
+
+  switch (nmeaId(thisSentence)) {
+  case nmeaId("GGA"): { //***************************************************GGA
     // GGA Global Positioning System Fix Data. Time, Position and fix related
     // data for a GPS receiver
     //       1         2       3 4        5 6 7  8   9  10 11 12 13  14  15
@@ -112,8 +114,10 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
                 milliseconds / 1000.,
             (double)latitude, lat, (double)longitude, lon, fixquality,
             satellites, (double)HDOP, (double)altitude, (double)geoidheight);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "GLL")) { //*****************************GLL
+  case nmeaId("GLL"): { //***************************************************GLL
     // GLL Geographic Position – Latitude/Longitude
     //       1       2 3        4 5         6 7
     //       |       | |        | |         | |
@@ -129,8 +133,10 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
             (double)longitude, lon,
             (double)hour * 10000L + minute * 100L + seconds +
                 milliseconds / 1000.);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "GSA")) { //*****************************GSA
+  case nmeaId("GSA"): { //***************************************************GSA
     // GSA GPS DOP and active satellites
     //       1 2 3                        14 15  16  17 18
     //       | | |                         | |   |   |   |
@@ -146,8 +152,9 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 17) VDOP in meters
     // 18) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "RMC")) { //*****************************RMC
+  case nmeaId("RMC"): { //***************************************************RMC
     // RMC Recommended Minimum Navigation Information
     //                                                            12
     //       1         2 3       4 5        6 7   8   9     10  11 |
@@ -171,8 +178,10 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
             (double)latitude, lat, (double)longitude, lon, (double)speed,
             (double)angle, day * 10000 + month * 100 + year,
             (double)magvariation, mag);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "APB")) { //*****************************APB
+  case nmeaId("APB"): { //***************************************************APB
     // APB Autopilot Sentence "B"
     //                                       13    15
     //       1 2 3   4 5 6 7 8   9 10   11 12 |  14 |
@@ -201,8 +210,9 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 14) M = Magnetic, T = True
     // 15) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "DBK")) { //*****************************DBT
+  case nmeaId("DBK"): { //***************************************************DBT
     // DBK Depth Below Keel
     //       1   2 3   4 5   6 7
     //       |   | |   | |   | |
@@ -215,8 +225,9 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 6) F = Fathoms
     // 7) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "DBS")) { //*****************************DBT
+  case nmeaId("DBS"): { //***************************************************DBT
     // DBS Depth Below Surface
     //       1   2 3   4 5   6 7
     //       |   | |   | |   | |
@@ -229,35 +240,9 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 6) F = Fathoms
     // 7) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "DBT")) { //*****************************DBT
-    // DBT Depth Below Transducer
-    //       1   2 3   4 5   6 7
-    //       |   | |   | |   | |
-    //$--DBT,x.x,f,x.x,M,x.x,F*hh
-    // 1) Depth, feet
-    // 2) f = feet
-    // 3) Depth, meters
-    // 4) M = meters
-    // 5) Depth, Fathoms
-    // 6) F = Fathoms
-    // 7) Checksum
-    double d = val[NMEA_DEPTH].latest - depthToTransducer;
-    sprintf(p, "%f,f,%f,M,,,", d / 0.3048, d);
-
-  } else if (!strcmp(thisSentence, "DPT")) { //*****************************DPT
-    // DPT Heading – Deviation & Variation
-    //       1   2   3
-    //       |   |   |
-    //$--DPT,x.x,x.x*hh
-    // 1) Depth, meters
-    // 2) Offset from transducer;
-    //      positive means distance from transducer to water line,
-    //      negative means distance from transducer to keel
-    // 3) Checksum
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "GSV")) { //*****************************GSV
+  case nmeaId("GSV"): { //***************************************************GSV
     // GSV Satellites in view
     //       1 2 3 4 5 6 7     n
     //       | | | | | | |     |
@@ -272,79 +257,9 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // more satellite infos like 4)-7)
     // n) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "HDG")) { //*****************************HDG
-    //  HDG Heading – Deviation & Variation
-    //       1   2   3 4   5 6
-    //       |   |   | |   | |
-    //$--HDG,x.x,x.x,a,x.x,a*hh
-    // 1) Magnetic Sensor heading in degrees
-    // 2) Magnetic Deviation, degrees
-    // 3) Magnetic Deviation direction, E = Easterly, W = Westerly
-    // 4) Magnetic Variation degrees
-    // 5) Magnetic Variation direction, E = Easterly, W = Westerly
-    // 6) Checksum
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "HDM")) { //*****************************HDM
-    // HDM Heading – Magnetic
-    //       1   2 3
-    //       |   | |
-    //$--HDM,x.x,M*hh
-    // 1) Heading Degrees, magnetic
-    // 2) M = magnetic
-    // 3) Checksum
-    sprintf(p, "%f,M", (double)val[NMEA_HDG].latest);
-
-  } else if (!strcmp(thisSentence, "HDT")) { //*****************************HDT
-    // HDT Heading – True
-    //       1   2 3
-    //       |   | |
-    //$--HDT,x.x,T*hh
-    // 1) Heading Degrees, true
-    // 2) T = True
-    // 3) Checksum
-    // starts with $II for integrated instrumentation
-    sprintf(p, "%f,T", (double)val[NMEA_HDT].latest);
-
-  } else if (!strcmp(thisSentence, "MDA")) { //*****************************MDA
-    // MDA Meteorological Composite
-    //       1   2 3   4 5   6 7   8 9 10 11  12
-    //       |   | |   | |   | |   | |  |  |   |
-    //$__MDA,x.x,I,x.x,B,x.x,C,x.x,C,x.x, ,x.x,C,,T,,M,,N,,M*hh
-    //$IIMDA,,I,,B,,C,21.8,C,,,,C,,T,,M,,N,,M*0F     // sent by RayMarine i70s
-    // Speed/Depth/Wind
-    // 1) Barometric Pressure
-    // 2) inches of Hg
-    // 3) Barometric Pressure
-    // 4) bar
-    // 5) Atmospheric Temperature
-    // 6) C or F
-    // 7) Water Temperature
-    // 8) C or F
-    // 9) Relative Humidity
-    // 10)
-    // 11) Dew Point
-    // 12) C or F
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "MTW")) { //*****************************MTW
-    // MTW Water Temperature
-    //       1   2 3
-    //       |   | |
-    //$IIMTW,x.x,C*hh
-    //$IIMTW,21.8,C*18     // sent by RayMarine i70s Speed/Depth/Wind
-    // 1) Degrees
-    // 2) Unit of Measurement, Celcius
-    // 3) Checksum
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "MWD")) { //*****************************MWD
-    // MWD Wind Direction & Speed
-    // Format unknown
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "MWV")) { //*****************************MWV
+  case nmeaId("MWV"): { //***************************************************MWV
     // MWV Wind Speed and Angle assuming values for True
     //       1   2 3   4 5 6
     //       |   | |   | | |
@@ -362,8 +277,10 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     else
       sprintf(p, "%f,%c,%f,N,A", (double)val[NMEA_TWA].latest, 'T',
               (double)val[NMEA_TWS].latest);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "RMB")) { //*****************************RMB
+  case nmeaId("RMB"): { //***************************************************RMB
     // RMB Recommended Minimum Navigation Information
     //       1 2   3 4    5    6       7 8        9 10  11 12  13 14
     //       | |   | |    |    |       | |        | |   |   |   | |
@@ -380,18 +297,10 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 12) Destination closing velocity in knots
     // 13) Arrival Status, A = Arrival Circle Entered 14) Checksum
     sprintf(p, ",,,,,,,,,,,%f,A", (double)val[NMEA_VMGWP].latest);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "ROT")) { //*****************************ROT
-    // ROT Rate Of Turn
-    //       1   2 3
-    //       |   | |
-    //$--ROT,x.x,A*hh
-    // 1) Rate Of Turn, degrees per minute, "-" means bow turns to port
-    // 2) Status, A means data is valid
-    // 3) Checksum
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "RPM")) { //*****************************RPM
+  case nmeaId("RPM"): { //***************************************************RPM
     // RPM Revolutions
     //       1 2 3   4   5 6
     //       | | |   |   | |
@@ -403,20 +312,9 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 5) Status, A means data is valid
     // 6) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "RSA")) { //*****************************RSA
-    //  RSA Rudder Sensor Angle
-    //       1   2 3   4 5
-    //       |   | |   | |
-    //$--RSA,x.x,A,x.x,A*hh
-    // 1) Starboard (or single) rudder sensor, "-" means Turn To Port
-    // 2) Status, A means data is valid
-    // 3) Port rudder sensor
-    // 4) Status, A means data is valid
-    // 5) Checksum
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "TXT")) { //*****************************TXT
+  case nmeaId("TXT"): { //***************************************************TXT
     // as mentioned in https://github.com/adafruit/Adafruit_GPS/issues/95
     // TXT Text Transmission
     //       1  2  3  4    5
@@ -428,80 +326,10 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 4) Text String, max 61 characters
     // 5) Checksum
     sprintf(p, "01,01,23,This is the text of the sample message");
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "VDR")) { //*****************************VDR
-    // VDR Set and Drift
-    //       1   2 3   4 5   6 7
-    //       |   | |   | |   | |
-    //$--VDR,x.x,T,x.x,M,x.x,N*hh
-    // 1) Degress True
-    // 2) T = True
-    // 3) Degrees Magnetic
-    // 4) M = Magnetic
-    // 5) Knots (speed of current)
-    // 6) N = Knots
-    // 7) Checksum
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "VHW")) { //*****************************VHW
-    // VHW Water Speed and Heading
-    //       1   2 3   4 5   6 7   8 9
-    //       |   | |   | |   | |   | |
-    //$--VHW,x.x,T,x.x,M,x.x,N,x.x,K*hh
-    //$IIVHW,,T,,M,0,N,0,K*55     // sent by RayMarine i70s Speed/Depth/Wind
-    // 1) Degrees True
-    // 2) T = True
-    // 3) Degrees Magnetic
-    // 4) M = Magnetic
-    // 5) Knots (speed of vessel relative to the water) [66]
-    // 6) N = Knots
-    // 7) Kilometers (speed of vessel relative to the water)
-    // 8) K = Kilometres
-    // 9) Checksum
-    sprintf(p, "%f,T,%f,M,%f,N,%f,K", (double)val[NMEA_HDT].latest,
-            (double)val[NMEA_HDG].latest, (double)val[NMEA_VTW].latest,
-            (double)val[NMEA_VTW].latest * 1.829);
-
-  } else if (!strcmp(thisSentence, "VLW")) { //*****************************VLW
-    // VLW Distance Traveled through Water
-    //       1   2 3   4 5
-    //       |   | |   | |
-    //$--VLW,x.x,N,x.x,N*hh
-    //$IIVLW,0,N,0,N,,N,,N*4D     // sent by RayMarine i70s Speed/Depth/Wind
-    // not sure what the last two are?
-    // 1) Total cumulative distance
-    // 2) N = Nautical Miles
-    // 3) Distance since Reset
-    // 4) N = Nautical Miles
-    // 5) Checksum
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "VPW")) { //*****************************VPW
-    // not supported by iNavX
-    // VPW Speed – Measured Parallel to Wind
-    //       1   2 3   4 5
-    //       |   | |   | |
-    //$--VPW,x.x,N,x.x,M*hh
-    // 1) Speed, "-" means downwind
-    // 2) N = Knots
-    // 3) Speed, "-" means downwind
-    // 4) M = Meters per second
-    // 5) Checksum
-    sprintf(p, "%f,N,,", (double)val[NMEA_VMG].latest);
-
-  } else if (!strcmp(thisSentence, "VTG")) { //*****************************VTG
-    // VTG Track Made Good and Ground Speed
-    //       1   2 3   4 5   6 7   8 9
-    //       |   | |   | |   | |   | |
-    //$--VTG,x.x,T,x.x,M,x.x,N,x.x,K*hh
-    // 1) Track Degrees               2) T = True
-    // 3) Track Degrees               4) M = Magnetic
-    // 5) Speed Knots                 6) N = Knots
-    // 7) Speed Kilometers Per Hour   8) K = Kilometres Per Hour
-    // 9) Checksum
-    return NULL;
-
-  } else if (!strcmp(thisSentence, "VWR")) { //*****************************VWR
+  case nmeaId("VWR"): { //***************************************************VWR
     // VWR Relative Wind Speed and Angle
     //       1   2 3   4 5   6 7   8 9
     //       |   | |   | |   | |   | |
@@ -518,16 +346,19 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 8) K = Kilometers Per Hour
     // 9) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "WCV")) { //*****************************WCV
-    // WCV Waypoint Closure Velocity
+  case nmeaId("WCV"): { //***************************************************WCV
+    // WCV Waypoint Closure Velocity, by hand for the waypoint ID
     //       1   2 3    4
     //       |   | |    |
     //$--WCV,x.x,N,c--c*hh
     // 1) Velocity 2) N = knots 3) Waypoint ID 4) Checksum
     sprintf(p, "%f,N,home", (double)val[NMEA_VMG].latest);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "XTE")) { //*****************************XTE
+  case nmeaId("XTE"): { //***************************************************XTE
     // XTE Cross-Track Error – Measured
     //       1 2 3   4 5  6
     //       | | |   | |  |
@@ -544,8 +375,9 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 5) Cross track units. N = Nautical Miles
     // 6) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "ZDA")) { //*****************************ZDA
+  case nmeaId("ZDA"): { //***************************************************ZDA
     // ZDA Time & Date – UTC, Day, Month, Year and Local Time Zone
     //       1         2  3  4    5  6  7
     //       |         |  |  |    |  |  |
@@ -558,18 +390,61 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     // 6) Time (UTC)
     // 7) Checksum
     return NULL;
+  }
 
-  } else {
-    return NULL; // didn't find a match for the build request
+  default: // the simple sentences come straight from the schema table
+    if (!buildSchema(p, nmeaId(thisSentence)))
+      return NULL; // didn't find a match for the build request
   }
 
   addChecksum(nmea); // Successful completion
   if (!noCRLF) { // Add Carriage Return and Line Feed to comply with NMEA-183
-    sprintf(nmea, "%s\r\n", nmea);
+    strcat(nmea, "\r\n");
   }
   return nmea; // return pointer to finished product
 }
 
+/**************************************************************************/
+/*!
+    @brief Write the fields of a sentence from its rows in the schema table,
+    converting each data value to the units of its field and following it
+    with the unit letter. Only the first of the alternative fields for a
+    value is written, and fields without a row are left empty.
+    @param p Pointer to where the first field goes
+    @param sentence The packed sentence ID
+    @return Pointer to the terminating 0, or NULL if the sentence is not in
+    the table
+*/
+/**************************************************************************/
+char *Adafruit_GPS::buildSchema(char *p, nmea_id_t sentence) {
+  bool found = false;
+  uint8_t at = 1; // the field that p is in
+  for (const nmea_schema_t *s = schema;; s++) {
+    nmea_schema_t row;
+    memcpy_P(&row, s, sizeof(row));
+    if (!row.sentence)
+      break;
+    if (row.sentence != sentence || (found && row.field <= at))
+      continue;
+    found = true;
+    for (; at < row.field; at++)
+      *p++ = ',';
+    if (row.idx < NMEA_MAX_INDEX) {
+      nmea_float_t v = val[row.idx].latest;
+      if (row.idx == NMEA_DEPTH)
+        v -= depthToTransducer;
+      p += sprintf(p, "%f", (double)convertUnit(v, row.unit, false));
+    }
+    if (row.tag) {
+      *p++ = ',';
+      *p++ = row.tag;
+      at++;
+    }
+  }
+  *p = 0;
+  return found ? p : NULL;
+}
+
 #endif // NMEA_EXTENSIONS
 
 /**************************************************************************/
@@ -578,17 +453,20 @@ char *Adafruit_GPS::build(char *nmea, const char *thisSource,
     the first character in the string. The checksum is the result of an
     exclusive or of all the characters in the string. Also useful if you
     are creating new PMTK strings for controlling a GPS module and need a
-    checksum added.
-    @param buff Pointer to the string, which must be long enough
+    checksum added, though pmtkCommand() in Adafruit_PMTK.h can do that at
+    compile time when the values are known.
+    @param buff Pointer to the string, which must have room for 3 more
+    characters
     @return none
 */
 /**************************************************************************/
 void Adafruit_GPS::addChecksum(char *buff) {
-  char cs = 0;
-  int i = 1;
-  while (buff[i]) {
-    cs ^= buff[i];
-    i++;
-  }
-  sprintf(buff, "%s*%02X", buff, cs);
+  uint8_t cs = 0;
+  char *p = buff + 1;
+  for (; *p; p++)
+    cs ^= *p;
+  *p++ = '*';
+  *p++ = pmtkHexDigit(cs >> 4);
+  *p++ = pmtkHexDigit(cs & 15);
+  *p = 0;
 }
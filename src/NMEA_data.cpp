@@ -43,8 +43,11 @@
 /**************************************************************************/
 void Adafruit_GPS::newDataValue(nmea_index_t idx, nmea_float_t v) {
 #ifdef NMEA_EXTENSIONS
+  if (!(valWanted[idx / 8] & (1 << (idx % 8))))
+    return; // nobody is interested, so skip the smoothing and history
   //  Serial.println();Serial.print(idx);Serial.print(", "); Serial.println(v);
-  val[idx].latest = v; // update the value
+  val[idx].latest = v;                   // update the value
+  valUpdated[idx / 8] |= 1 << (idx % 8); // for the onValue() handlers
 
   // update the smoothed verion
   if (isCompoundAngle(idx)) { // angle with sin/cos component recording
@@ -106,6 +109,7 @@ void Adafruit_GPS::newDataValue(nmea_index_t idx, nmea_float_t v) {
 /**************************************************************************/
 void Adafruit_GPS::data_init() {
 #ifdef NMEA_EXTENSIONS
+  wantAllValues(); // until the sketch says otherwise
   // fill all the data values with nothing
   static char c[] = "NUL";
   for (int i = 0; i < (int)NMEA_MAX_INDEX; i++) {
@@ -288,10 +292,197 @@ void Adafruit_GPS::data_init() {
   static char BAROMETERfmt[] = "%6.0f";
   static char BAROMETERunit[] = "Pa";
   initDataValue(NMEA_BAROMETER, BAROMETERlabel, BAROMETERfmt, BAROMETERunit);
+
+  static char ROTlabel[] = "ROT";
+  static char ROTunit[] = "Deg/min";
+  initDataValue(NMEA_ROT, ROTlabel, Anglefmt, ROTunit);
+
+  static char RUDDERlabel[] = "Rudder";
+  initDataValue(NMEA_RUDDER, RUDDERlabel, Anglefmt, BoatAngleunit, 0,
+                NMEA_BOAT_ANGLE); // type: angle +/-180 2
+
+  static char SETlabel[] = "Set";
+  initDataValue(NMEA_SET, SETlabel, Anglefmt, TrueAngleunit, 0,
+                NMEA_COMPASS_ANGLE); // type: angle 0-360 1
+
+  static char DRIFTlabel[] = "Drift";
+  initDataValue(NMEA_DRIFT, DRIFTlabel, BoatSpeedfmt, Speedunit);
 #endif // NMEA_EXTENSIONS
 }
 
 #ifdef NMEA_EXTENSIONS
+// The sentences that are nothing more than numbers for data values, each
+// with an optional unit letter after it, as a row for each of those fields.
+// A sentence costs a few rows here instead of a case in both parse() and
+// build(). Rows for a sentence are in field order so that build() can write
+// them out in one pass. Rows for the same value in different units sit
+// together, and parse() takes the first one that the talker filled in. A row
+// with NMEA_MAX_INDEX just makes build() leave room for a field, so the last
+// row of a sentence is always its last field, even if that is left empty.
+const nmea_schema_t Adafruit_GPS::schema[] PROGMEM = {
+    //$--DBT,x.x,f,x.x,M,x.x,F*hh  Depth Below Transducer, coerced to depth
+    // from the surface by adding depthToTransducer
+    {nmeaId("DBT"), 1, NMEA_DEPTH, NMEA_UNIT_FEET, 'f'},
+    {nmeaId("DBT"), 3, NMEA_DEPTH, NMEA_UNIT_SAME, 'M'},
+    {nmeaId("DBT"), 5, NMEA_DEPTH, NMEA_UNIT_FATHOMS, 'F'},
+    //$--DPT,x.x,x.x*hh  Depth below transducer in metres, offset
+    {nmeaId("DPT"), 1, NMEA_DEPTH, NMEA_UNIT_SAME, 0},
+    {nmeaId("DPT"), 2, NMEA_MAX_INDEX, NMEA_UNIT_SAME, 0},
+    //$--HDG,x.x,x.x,a,x.x,a*hh  Magnetic sensor heading, deviation, variation
+    {nmeaId("HDG"), 1, NMEA_HDG, NMEA_UNIT_SAME, 0},
+    {nmeaId("HDG"), 5, NMEA_MAX_INDEX, NMEA_UNIT_SAME, 0},
+    //$--HDM,x.x,M*hh  Heading, magnetic
+    {nmeaId("HDM"), 1, NMEA_HDG, NMEA_UNIT_SAME, 'M'},
+    //$--HDT,x.x,T*hh  Heading, true
+    {nmeaId("HDT"), 1, NMEA_HDT, NMEA_UNIT_SAME, 'T'},
+    //$--MDA,x.x,I,x.x,B,x.x,C,x.x,C,x.x,,x.x,C,,T,,M,,N,,M*hh  Meteorological
+    // Composite: pressure, air temperature, water temperature, humidity
+    {nmeaId("MDA"), 1, NMEA_BAROMETER, NMEA_UNIT_INHG, 'I'},
+    {nmeaId("MDA"), 3, NMEA_BAROMETER, NMEA_UNIT_BAR, 'B'},
+    {nmeaId("MDA"), 5, NMEA_TEMPERATURE_AIR, NMEA_UNIT_SAME, 'C'},
+    {nmeaId("MDA"), 5, NMEA_TEMPERATURE_AIR, NMEA_UNIT_F, 'F'},
+    {nmeaId("MDA"), 7, NMEA_TEMPERATURE_WATER, NMEA_UNIT_SAME, 'C'},
+    {nmeaId("MDA"), 7, NMEA_TEMPERATURE_WATER, NMEA_UNIT_F, 'F'},
+    {nmeaId("MDA"), 9, NMEA_HUMIDITY, NMEA_UNIT_SAME, 0},
+    {nmeaId("MDA"), 20, NMEA_MAX_INDEX, NMEA_UNIT_SAME, 0},
+    //$--MTW,x.x,C*hh  Water Temperature
+    {nmeaId("MTW"), 1, NMEA_TEMPERATURE_WATER, NMEA_UNIT_SAME, 'C'},
+    {nmeaId("MTW"), 1, NMEA_TEMPERATURE_WATER, NMEA_UNIT_F, 'F'},
+    //$--MWD,x.x,T,x.x,M,x.x,N,x.x,M*hh  Wind Direction & Speed
+    {nmeaId("MWD"), 3, NMEA_TWD, NMEA_UNIT_SAME, 'M'},
+    {nmeaId("MWD"), 5, NMEA_TWS, NMEA_UNIT_SAME, 'N'},
+    {nmeaId("MWD"), 7, NMEA_TWS, NMEA_UNIT_MS, 'M'},
+    //$--ROT,x.x,A*hh  Rate Of Turn, skipped unless the status is A
+    {nmeaId("ROT"), 1, NMEA_ROT, NMEA_UNIT_SAME, 'A'},
+    //$--RSA,x.x,A,x.x,A*hh  Rudder Sensor Angle, starboard or single, then
+    // port
+    {nmeaId("RSA"), 1, NMEA_RUDDER, NMEA_UNIT_SAME, 'A'},
+    {nmeaId("RSA"), 4, NMEA_MAX_INDEX, NMEA_UNIT_SAME, 0},
+    //$--VDR,x.x,T,x.x,M,x.x,N*hh  Set and Drift of the current
+    {nmeaId("VDR"), 1, NMEA_SET, NMEA_UNIT_SAME, 'T'},
+    {nmeaId("VDR"), 5, NMEA_DRIFT, NMEA_UNIT_SAME, 'N'},
+    //$--VHW,x.x,T,x.x,M,x.x,N,x.x,K*hh  Water Speed and Heading
+    {nmeaId("VHW"), 1, NMEA_HDT, NMEA_UNIT_SAME, 'T'},
+    {nmeaId("VHW"), 3, NMEA_HDG, NMEA_UNIT_SAME, 'M'},
+    {nmeaId("VHW"), 5, NMEA_VTW, NMEA_UNIT_SAME, 'N'},
+    {nmeaId("VHW"), 7, NMEA_VTW, NMEA_UNIT_KMH, 'K'},
+    //$--VLW,x.x,N,x.x,N*hh  Distance Traveled through Water, total and since
+    // reset
+    {nmeaId("VLW"), 1, NMEA_LOG, NMEA_UNIT_SAME, 'N'},
+    {nmeaId("VLW"), 3, NMEA_LOGR, NMEA_UNIT_SAME, 'N'},
+    //$--VPW,x.x,N,x.x,M*hh  Speed Measured Parallel to Wind
+    {nmeaId("VPW"), 1, NMEA_VMG, NMEA_UNIT_SAME, 'N'},
+    {nmeaId("VPW"), 3, NMEA_VMG, NMEA_UNIT_MS, 'M'},
+    //$--VTG,x.x,T,x.x,M,x.x,N,x.x,K*hh  Track Made Good and Ground Speed
+    {nmeaId("VTG"), 1, NMEA_COG, NMEA_UNIT_SAME, 'T'},
+    {nmeaId("VTG"), 5, NMEA_SOG, NMEA_UNIT_SAME, 'N'},
+    {nmeaId("VTG"), 7, NMEA_SOG, NMEA_UNIT_KMH, 'K'},
+    //$--WCV,x.x,N,c--c*hh  Waypoint Closure Velocity, waypoint ID. build()
+    // has a case of its own to write the ID, so this is only for parse()
+    {nmeaId("WCV"), 1, NMEA_VMGWP, NMEA_UNIT_SAME, 'N'},
+    {0, 0, NMEA_MAX_INDEX, NMEA_UNIT_SAME, 0} // end of the table
+};
+
+/**************************************************************************/
+/*!
+    @brief Convert a number between the units of a sentence field and the
+    units of its data value.
+    @param v The number to convert
+    @param unit The nmea_unit_t of the sentence field
+    @param toData true to convert from the field to the data value units,
+    false to go the other way for build()
+    @return The converted number
+*/
+/**************************************************************************/
+nmea_float_t Adafruit_GPS::convertUnit(nmea_float_t v, uint8_t unit,
+                                       bool toData) {
+  nmea_float_t scale = 1, offset = 0; // data = (field - offset) * scale
+  switch (unit) {
+  case NMEA_UNIT_FEET:
+    scale = 0.3048f;
+    break;
+  case NMEA_UNIT_FATHOMS:
+    scale = 1.8288f;
+    break;
+  case NMEA_UNIT_KMH:
+    scale = 1 / 1.852f;
+    break;
+  case NMEA_UNIT_MS:
+    scale = 3600 / 1852.f;
+    break;
+  case NMEA_UNIT_INHG:
+    scale = 3386.39f;
+    break;
+  case NMEA_UNIT_BAR:
+    scale = 100000;
+    break;
+  case NMEA_UNIT_F:
+    scale = 1 / 1.8f;
+    offset = 32;
+    break;
+  }
+  return toData ? (v - offset) * scale : v / scale + offset;
+}
+
+/**************************************************************************/
+/*!
+    @brief Register a function for parse() to call each time a sentence it
+    successfully parses updates a data value, e.g.
+
+      nmea.onValue(NMEA_TWS, gotWindSpeed);
+
+    Compound angles also update their _SIN and _COS values, which can have
+    handlers of their own. Registering again replaces the handler and a NULL
+    handler removes it.
+    @param idx The data value index
+    @param handler The function to call, or NULL to remove it
+    @return true if registered, false if idx is out of range
+*/
+/**************************************************************************/
+bool Adafruit_GPS::onValue(nmea_index_t idx, nmea_value_handler_t handler) {
+  if (idx >= NMEA_MAX_INDEX || idx < NMEA_HDOP)
+    return false;
+  valueHandlers[idx] = handler;
+  if (handler)
+    wantValue(idx); // no point having a handler for a value that is skipped
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Choose whether parse() updates a data value. Values nobody wants
+    skip newDataValue() entirely, saving the smoothing, sin/cos and history
+    work. Compound angles bring their _SIN and _COS values along with them.
+    The public variables like latitude and speed are always updated.
+    @param idx The data value index
+    @param wanted true to update it, false to skip it
+    @return true if set, false if idx is out of range
+*/
+/**************************************************************************/
+bool Adafruit_GPS::wantValue(nmea_index_t idx, bool wanted) {
+  if (idx >= NMEA_MAX_INDEX || idx < NMEA_HDOP)
+    return false;
+  uint8_t n = isCompoundAngle(idx) ? 3 : 1;
+  for (uint8_t i = idx; i < idx + n; i++) {
+    if (wanted)
+      valWanted[i / 8] |= 1 << (i % 8);
+    else
+      valWanted[i / 8] &= ~(1 << (i % 8));
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Choose whether parse() updates all of the data values, e.g. turn
+    them all off and then wantValue() the few that the sketch uses.
+    @param wanted true to update them all, false to skip them all
+*/
+/**************************************************************************/
+void Adafruit_GPS::wantAllValues(bool wanted) {
+  memset(valWanted, wanted ? 0xFF : 0, sizeof(valWanted));
+}
+
 /**************************************************************************/
 /*!
     @brief Clearer approach to retrieving NMEA values by allowing calls that
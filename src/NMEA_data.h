@@ -174,6 +174,10 @@ typedef enum {
   NMEA_HUMIDITY,          ///< outside relative humidity in %
   NMEA_BAROMETER, ///< barometric pressure in Pa absolute -- not altitude
                   ///< corrected
+  NMEA_ROT,       ///< rate of turn in degrees per minute, -ve to port
+  NMEA_RUDDER,    ///< rudder angle in degrees, -ve to port
+  NMEA_SET,       ///< direction the current flows toward, degrees true
+  NMEA_DRIFT,     ///< speed of the current in knots
   NMEA_USR_00,    ///< spaces for a user sketch to inject its own data
   NMEA_USR_01,    ///< spaces for a user sketch to inject its own data
   NMEA_USR_02,    ///< spaces for a user sketch to inject its own data
@@ -191,4 +195,37 @@ typedef enum {
                  ///< but does define size of data value array required.
 } nmea_index_t;  ///< Indices for data values expected to change often with time
 
+/**************************************************************************/
+/*!
+    Units that a sentence field can hold. parse() coerces each one to the
+    units of its data value, and build() converts back again.
+ */
+/**************************************************************************/
+typedef enum {
+  NMEA_UNIT_SAME = 0, ///< already in the units of the data value
+  NMEA_UNIT_FEET,     ///< feet, coerced to metres
+  NMEA_UNIT_FATHOMS,  ///< fathoms, coerced to metres
+  NMEA_UNIT_KMH,      ///< kilometres per hour, coerced to knots
+  NMEA_UNIT_MS,       ///< metres per second, coerced to knots
+  NMEA_UNIT_INHG,     ///< inches of mercury, coerced to Pa
+  NMEA_UNIT_BAR,      ///< bar, coerced to Pa
+  NMEA_UNIT_F         ///< degrees Fahrenheit, coerced to Celsius
+} nmea_unit_t;
+
+/**************************************************************************/
+/*!
+    One row of the sentence schema, describing a numeric field that holds a
+    data value and the unit letter, if any, in the field after it. Sentences
+    with nothing more to them than this are parsed and built from their rows
+    alone.
+ */
+/**************************************************************************/
+typedef struct {
+  uint32_t sentence; ///< packed sentence ID, e.g. nmeaId("HDM")
+  uint8_t field;     ///< field number, counting from 1 after the ID
+  uint8_t idx;       ///< the nmea_index_t it holds, NMEA_MAX_INDEX for none
+  uint8_t unit;      ///< the nmea_unit_t the field is in
+  char tag;          ///< unit letter for the next field, or 0 if none
+} nmea_schema_t;
+
 #endif // _NMEA_DATA_H
@@ -0,0 +1,268 @@
+/**************************************************************************/
+/*!
+  @file NMEA_locus.cpp
+
+  Decoding of the LOCUS log flash dump that PMTK_LOCUS_DUMP asks for. The
+  module answers with $PMTKLOX,0,n to say how many lines follow, then n
+  $PMTKLOX,1,line,... lines of up to 24 hex words, then $PMTKLOX,2. Each
+  4096 byte sector of the flash starts with a 64 byte header, followed by
+  16 byte records:
+
+    UTC seconds (4 bytes), fix type (1), latitude float (4), longitude
+    float (4), height in metres (2), XOR of the first 15 bytes (1)
+
+  all little endian. The lines are too long for the sentence queue, so
+  read() hands their characters to locusChar() instead, which assembles
+  the records as the hex goes by, without keeping the line.
+
+  Adafruit invests time and resources providing this open source code,
+  please support Adafruit and open-source hardware by purchasing
+  products from Adafruit!
+
+  @copyright BSD license, check license.txt for more information
+  All text above must be included in any redistribution
+*/
+/**************************************************************************/
+
+#include <Adafruit_GPS.h>
+
+#define LOCUS_LINE_BYTES 96     ///< data bytes in each full $PMTKLOX line
+#define LOCUS_SECTOR_BYTES 4096 ///< flash sector, starting with a header
+#define LOCUS_HEADER_BYTES 64   ///< sector header before the records
+#define LOCUS_RECORD_BYTES 16   ///< bytes in each basic record
+#define LOCUS_SECTOR_RECORDS                                                   \
+  ((LOCUS_SECTOR_BYTES - LOCUS_HEADER_BYTES) /                                 \
+   LOCUS_RECORD_BYTES) ///< records that fit in a sector
+
+/**************************************************************************/
+/*!
+    @brief Ask the module to dump its log flash. read() decodes the records
+    as they arrive, and update() passes them to the handler set with
+    LOCUS_onRecord(), or they wait for LOCUS_readRecords(). Watch
+    LOCUS_dumping and the other LOCUS_dump variables for progress. Turn off
+    the sentence output with PMTK_SET_NMEA_OUTPUT_OFF first so the dump
+    isn't interleaved with them.
+    @param from Index of the first record wanted. The module always sends
+    the whole flash, but the lines before this record are only
+    checksummed, not decoded.
+*/
+/**************************************************************************/
+void Adafruit_GPS::LOCUS_StartDump(uint16_t from) {
+  lxFrom = (uint32_t)(from / LOCUS_SECTOR_RECORDS) * LOCUS_SECTOR_BYTES +
+           LOCUS_HEADER_BYTES +
+           (from % LOCUS_SECTOR_RECORDS) * LOCUS_RECORD_BYTES;
+  LOCUS_synced = from;
+  LOCUS_dumping = false;
+  LOCUS_dumpLines = LOCUS_dumpRecords = 0;
+  LOCUS_dumpErrors = LOCUS_dumpDropped = 0;
+  sendCommand(PMTK_LOCUS_DUMP);
+}
+
+/**************************************************************************/
+/*!
+    @brief Fetch the records logged since the last sync. Asks the module how
+    many records it holds, then dumps from LOCUS_synced, which
+    LOCUS_readRecords() moves on for as long as the records it hands over
+    follow on without a gap. A record that was dropped, or lost to a bad
+    checksum, holds LOCUS_synced back, so if a sync is cut short or has
+    errors, the next one starts again at the first record missed. A record
+    that is corrupt in the flash itself comes back the same every time, so
+    a sketch that sees LOCUS_synced stuck on it can step it past. Save
+    LOCUS_synced somewhere that survives a reset, such as EEPROM, to resume
+    after one too.
+    @return True if a dump was started, false if there is nothing new or
+    the module didn't answer
+*/
+/**************************************************************************/
+bool Adafruit_GPS::LOCUS_Sync(void) {
+  if (!LOCUS_ReadStatus())
+    return false;
+  if (LOCUS_records < LOCUS_synced)
+    LOCUS_synced = 0; // the log has been erased since
+  if (LOCUS_records == LOCUS_synced)
+    return false;
+  LOCUS_StartDump(LOCUS_synced);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Register a function for update() to call with each record
+    decoded from a LOCUS dump, e.g. to write it to an SD card.
+    @param handler The function to call, or NULL to leave the records for
+    LOCUS_readRecords()
+*/
+/**************************************************************************/
+void Adafruit_GPS::LOCUS_onRecord(locus_record_handler_t handler) {
+  locusHandler = handler;
+}
+
+/**************************************************************************/
+/*!
+    @brief Take the records that read() has decoded from a LOCUS dump,
+    oldest first. Only LOCUS_RECORD_QUEUE - 1 are held, a line's worth or
+    so, so call it at least once per line; the rest are counted in
+    LOCUS_dumpDropped. Moves LOCUS_synced on past the ones that follow it
+    without a gap.
+    @param records Buffer for the records
+    @param max Number of records the buffer holds
+    @return Number of records copied into the buffer
+*/
+/**************************************************************************/
+uint16_t Adafruit_GPS::LOCUS_readRecords(locus_record_t *records,
+                                         uint16_t max) {
+  uint8_t head = __atomic_load_n(&lxHead, __ATOMIC_ACQUIRE);
+  uint8_t tail = lxTail;
+  uint16_t n = 0;
+  while (tail != head && n < max) {
+    records[n++] = lxRing[tail];
+    tail = (tail + 1) % LOCUS_RECORD_QUEUE;
+  }
+  __atomic_store_n(&lxTail, tail, __ATOMIC_RELEASE); // free the slots
+  for (uint16_t i = 0; i < n; i++)
+    if (records[i].index == LOCUS_synced)
+      LOCUS_synced++; // and never again once a record is missing
+  return n;
+}
+
+/**************************************************************************/
+/*!
+    @brief Decode one character of a $PMTKLOX line, after read() has seen
+    the "$PMTKLOX," that starts it. Keeps the checksum in rxSum.
+    @param c The character
+*/
+/**************************************************************************/
+void Adafruit_GPS::locusChar(char c) {
+  if (c == '\n') {
+    locusEnd();
+    rxState = RX_HUNT;
+    return;
+  }
+  if (c == '\r')
+    return;
+  if (lxStar) { // the two hex digits of the checksum
+    if (lxStar++ < 3)
+      lxCheck = lxCheck * 16 + parseHex(c);
+    return;
+  }
+  if (c == '*') {
+    lxStar = 1;
+    return;
+  }
+  rxSum ^= c;
+  if (c == ',') {
+    if (++lxField == 3 && lxType == 1) { // the data starts after the line
+      lxOffset = (uint32_t)lxLine * LOCUS_LINE_BYTES;
+      lxSkip = lxOffset + LOCUS_LINE_BYTES <= lxFrom; // all synced already
+    }
+    lxHalf = false;
+    return;
+  }
+  if (lxField < 3) { // type, then line number or line count
+    if (!isDigit(c))
+      lxBad = true;
+    else if (lxField == 1)
+      lxType = c - '0';
+    else
+      lxLine = lxLine * 10 + c - '0';
+    return;
+  }
+  if (lxSkip)
+    return;
+  if (!isDigit(c) && (c < 'A' || c > 'F')) { // upper case, like parseHex()
+    lxBad = true;
+    return;
+  }
+  lxByte = lxByte * 16 + parseHex(c);
+  lxHalf = !lxHalf;
+  if (!lxHalf)
+    locusByte(lxByte);
+}
+
+/**************************************************************************/
+/*!
+    @brief Add a byte from a $PMTKLOX data line to the record being
+    assembled, skipping the sector headers, and queue the record once it is
+    complete and its checksum matches.
+    @param b The byte
+*/
+/**************************************************************************/
+void Adafruit_GPS::locusByte(uint8_t b) {
+  uint32_t offset = lxOffset++;
+  if (offset < lxFrom || offset % LOCUS_SECTOR_BYTES < LOCUS_HEADER_BYTES)
+    return;
+  lxRec[lxRecIdx++] = b;
+  if (lxRecIdx < sizeof(lxRec))
+    return;
+  lxRecIdx = 0;
+
+  uint8_t sum = 0, ff = 0xFF;
+  for (uint8_t i = 0; i < sizeof(lxRec) - 1; i++) {
+    sum ^= lxRec[i];
+    ff &= lxRec[i];
+  }
+  if (ff == 0xFF)
+    return; // erased flash, past the end of the log
+  if (sum != lxRec[15]) {
+    LOCUS_dumpErrors++;
+    return;
+  }
+  uint8_t next = (lxPending + 1) % LOCUS_RECORD_QUEUE;
+  if (next == __atomic_load_n(&lxTail, __ATOMIC_ACQUIRE)) {
+    LOCUS_dumpDropped++;
+    return;
+  }
+  locus_record_t *r = &lxRing[lxPending];
+  uint32_t lat = 0, lon = 0;
+  r->utc = 0;
+  for (int8_t i = 3; i >= 0; i--) {
+    r->utc = (r->utc << 8) | lxRec[i];
+    lat = (lat << 8) | lxRec[5 + i];
+    lon = (lon << 8) | lxRec[9 + i];
+  }
+  r->fix = lxRec[4];
+  memcpy(&r->latitude, &lat, sizeof(float));
+  memcpy(&r->longitude, &lon, sizeof(float));
+  r->height = (int16_t)(lxRec[13] | (lxRec[14] << 8));
+  offset -= LOCUS_RECORD_BYTES - 1; // back to the start of the record
+  r->index = (offset / LOCUS_SECTOR_BYTES) * LOCUS_SECTOR_RECORDS +
+             (offset % LOCUS_SECTOR_BYTES - LOCUS_HEADER_BYTES) /
+                 LOCUS_RECORD_BYTES;
+  lxPending = next;
+}
+
+/**************************************************************************/
+/*!
+    @brief Finish a $PMTKLOX line. If its checksum matches, act on the start
+    or end of the dump, or publish the records from a data line. If not,
+    throw away its records.
+*/
+/**************************************************************************/
+void Adafruit_GPS::locusEnd(void) {
+  uint8_t head = lxHead;
+  if (lxBad || lxStar < 3 || lxCheck != rxSum) {
+    lxPending = head; // forget this line's records
+    LOCUS_dumpErrors++;
+    return;
+  }
+  switch (lxType) {
+  case 0: // $PMTKLOX,0,n starts a dump of n lines
+    LOCUS_dumpLines = lxLine;
+    LOCUS_dumping = true;
+    lxNext = 0;
+    break;
+  case 1: // $PMTKLOX,1,line,words...
+    if (lxLine > lxNext)
+      LOCUS_dumpErrors += lxLine - lxNext; // missed some
+    lxNext = lxLine + 1;
+    LOCUS_dumpRecords +=
+        (lxPending + LOCUS_RECORD_QUEUE - head) % LOCUS_RECORD_QUEUE;
+    __atomic_store_n(&lxHead, lxPending, __ATOMIC_RELEASE);
+    break;
+  case 2: // $PMTKLOX,2 ends it
+    if (LOCUS_dumpLines > lxNext)
+      LOCUS_dumpErrors += LOCUS_dumpLines - lxNext; // missed the last ones
+    LOCUS_dumping = false;
+    break;
+  }
+}
@@ -22,6 +22,15 @@
 
 #include <Adafruit_GPS.h>
 
+/// Talker IDs that check() recognises, shared by every object and kept in
+/// flash where there is PROGMEM. addSource() can add more at run time.
+static const nmea_id_t builtinSources[] PROGMEM = {
+    nmeaId("II"), nmeaId("WI"), nmeaId("GP"), nmeaId("PG"),
+    nmeaId("GN"), nmeaId("P"),  nmeaId("GL"), nmeaId("GA"),
+    nmeaId("GB"), nmeaId("BD"), nmeaId("GQ"), nmeaId("AI")};
+
+nmea_id_t Adafruit_GPS::extraSources[NMEA_MAX_EXTRA_SOURCES] = {0};
+
 /**************************************************************************/
 /*!
     @brief Parse a standard NMEA string and update the relevant variables.
@@ -49,32 +58,81 @@
 */
 /**************************************************************************/
 bool Adafruit_GPS::parse(char *nmea) {
-  if (!check(nmea))
+  bool parsed = decode(nmea, strlen(nmea));
+  nameIds(); // fill in the strings for older sketches
+  if (parsed) {
+    strcpy(lastSource, thisSource);
+    strcpy(lastSentence, thisSentence);
+    dispatch();
+  }
+  return parsed;
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse an NMEA sentence in place, without copying it or needing it
+    to be writeable or 0 terminated, e.g. straight out of a DMA buffer or a
+    memory mapped log. Works like parse(char *), except that the source and
+    sentence IDs are only recorded as codes in thisSourceId, thisSentenceId,
+    lastSourceId and lastSentenceId, and thisSource, thisSentence, lastSource
+    and lastSentence are left alone.
+    @param nmea Pointer to the start of the sentence
+    @param len Number of characters in the sentence, with or without CR/LF
+    @return True if successfully parsed, false if fails check or parsing
+*/
+/**************************************************************************/
+bool Adafruit_GPS::parse(const char *nmea, size_t len) {
+  if (!decode(nmea, len))
+    return false;
+  dispatch();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Decode a sentence into the object's variables for parse(), before
+    any handlers are called.
+    @param nmea Pointer to the start of the sentence
+    @param len Number of characters in the sentence, with or without CR/LF
+    @return True if successfully parsed, false if fails check or parsing
+*/
+/**************************************************************************/
+bool Adafruit_GPS::decode(const char *nmea, size_t len) {
+#ifdef NMEA_EXTENSIONS
+  memset(valUpdated, 0, sizeof(valUpdated)); // newDataValue() marks them
+#endif
+  // $PMTK replies are always wanted, or tracked commands would time out
+  if (!check(nmea, len) ||
+      !(sentenceBit(thisSentenceId) & (sentenceMask | NMEA_MASK_MTK)))
     return false;
-  // passed the check, so there's a valid source in thisSource and a valid
-  // sentence in thisSentence
-  char *p = nmea; // Pointer to move through the sentence -- good parsers are
-                  // non-destructive
-  p = strchr(p, ',') + 1; // Skip to char after the next comma, then check.
-
-  // This may look inefficient, but an M0 will get down the list in about 1 us /
-  // strcmp()! Put the GPS sentences from Adafruit_GPS at the top to make
-  // pruning excess code easier. Otherwise, keep them alphabetical for ease of
-  // reading.
-  if (!strcmp(thisSentence, "GGA")) { //************************************GGA
+  // passed the check, so there's a valid source in thisSourceId and a valid
+  // sentence in thisSentenceId that we want. Find all of the fields in one
+  // pass, then the sentences below can go straight to the ones they want.
+  // Fields past the end of a short sentence just look empty.
+  if (!indexFields(nmea))
+    return false;
+  const char *p = field(1); // Pointer to move through the sentence -- good
+                            // parsers are non-destructive
+
+  // The compiler turns a switch on the packed IDs into a jump table or a
+  // binary search, so where a sentence sits in the list doesn't matter. Put
+  // the GPS sentences from Adafruit_GPS at the top to make pruning excess code
+  // easier. Otherwise, keep them alphabetical for ease of reading. Sentences
+  // that are only data values and their units are rows in the schema table
+  // in NMEA_data.cpp instead, and are decoded by the default.
+  switch (thisSentenceId) {
+  case nmeaId("GGA"): { //***************************************************GGA
     // Adafruit from Actisense NGW-1 from SH CP150C
     parseTime(p);
-    p = strchr(p, ',') + 1; // parse time with specialized function
+    p = field(2); // parse time with specialized function
     // parse out both latitude and direction, then go to next field, or fail
     if (parseCoord(p, &latitudeDegrees, &latitude, &latitude_fixed, &lat))
       newDataValue(NMEA_LAT, latitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    p = field(4);
     // parse out both longitude and direction, then go to next field, or fail
     if (parseCoord(p, &longitudeDegrees, &longitude, &longitude_fixed, &lon))
       newDataValue(NMEA_LON, longitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    p = field(6);
     if (!isEmpty(p)) { // if it's a , (or a * at end of sentence) the value is
                        // not included
       fixquality = atoi(p); // needs additional processing
@@ -84,217 +142,163 @@ bool Adafruit_GPS::parse(char *nmea) {
       } else
         fix = false;
     }
-    p = strchr(p, ',') + 1; // then move on to the next
-    // Most can just be parsed with atoi() or atof(), then move on to the next.
+    p = field(7); // then move on to the next
+    // Most can just be parsed with atoi() or parseFloat(), then move on.
     if (!isEmpty(p))
       satellites = atoi(p);
-    p = strchr(p, ',') + 1;
+    p = field(8);
     if (!isEmpty(p))
-      newDataValue(NMEA_HDOP, HDOP = atof(p));
-    p = strchr(p, ',') + 1;
+      newDataValue(NMEA_HDOP, HDOP = parseFloat(p));
+    p = field(9);
     if (!isEmpty(p))
-      altitude = atof(p);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1; // skip the units
+      altitude = parseFloat(p);
+    p = field(11); // skip the units
     if (!isEmpty(p))
-      geoidheight = atof(p); // skip the rest
+      geoidheight = parseFloat(p); // skip the rest
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "RMC")) { //*****************************RMC
+  case nmeaId("RMC"): { //***************************************************RMC
     // in Adafruit from Actisense NGW-1 from SH CP150C
     parseTime(p);
-    p = strchr(p, ',') + 1;
+    p = field(2);
     parseFix(p);
-    p = strchr(p, ',') + 1;
+    p = field(3);
     // parse out both latitude and direction, then go to next field, or fail
     if (parseCoord(p, &latitudeDegrees, &latitude, &latitude_fixed, &lat))
       newDataValue(NMEA_LAT, latitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    p = field(5);
     // parse out both longitude and direction, then go to next field, or fail
     if (parseCoord(p, &longitudeDegrees, &longitude, &longitude_fixed, &lon))
       newDataValue(NMEA_LON, longitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    p = field(7);
     if (!isEmpty(p))
-      newDataValue(NMEA_SOG, speed = atof(p));
-    p = strchr(p, ',') + 1;
+      newDataValue(NMEA_SOG, speed = parseFloat(p));
+    p = field(8);
     if (!isEmpty(p))
-      newDataValue(NMEA_COG, angle = atof(p));
-    p = strchr(p, ',') + 1;
+      newDataValue(NMEA_COG, angle = parseFloat(p));
+    p = field(9);
     if (!isEmpty(p)) {
-      uint32_t fulldate = atof(p);
+      uint32_t fulldate = atol(p);
       day = fulldate / 10000;
       month = (fulldate % 10000) / 100;
       year = (fulldate % 100);
       lastDate = sentTime;
     } // skip the rest
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "GLL")) { //*****************************GLL
+  case nmeaId("GLL"): { //***************************************************GLL
     // in Adafruit from Actisense NGW-1 from SH CP150C
     // parse out both latitude and direction, then go to next field, or fail
     if (parseCoord(p, &latitudeDegrees, &latitude, &latitude_fixed, &lat))
       newDataValue(NMEA_LAT, latitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    p = field(3);
     // parse out both longitude and direction, then go to next field, or fail
     if (parseCoord(p, &longitudeDegrees, &longitude, &longitude_fixed, &lon))
       newDataValue(NMEA_LON, longitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    p = field(5);
     parseTime(p);
-    p = strchr(p, ',') + 1;
+    p = field(6);
     parseFix(p); // skip the rest
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "GSA")) { //*****************************GSA
+  case nmeaId("GSA"): { //***************************************************GSA
     // in Adafruit from Actisense NGW-1
-    p = strchr(p, ',') + 1; // skip selection mode
+    p = field(2); // skip selection mode
     if (!isEmpty(p))
       fixquality_3d = atoi(p);
-    p = strchr(p, ',') + 1;
-    // skip 12 Satellite PDNs without interpreting them
-    for (int i = 0; i < 12; i++)
-      p = strchr(p, ',') + 1;
+#ifdef NMEA_EXTENSIONS
+    decodeGSAUsed(); // the 12 satellite PRNs, to mark them in the GSV table
+#endif
+    p = field(15);
     if (!isEmpty(p))
-      PDOP = atof(p);
-    p = strchr(p, ',') + 1;
+      PDOP = parseFloat(p);
+    p = field(16);
     // parse out HDOP, we also parse this from the GGA sentence. Chipset should
     // report the same for both
     if (!isEmpty(p))
-      newDataValue(NMEA_HDOP, HDOP = atof(p));
-    p = strchr(p, ',') + 1;
+      newDataValue(NMEA_HDOP, HDOP = parseFloat(p));
+    p = field(17);
     if (!isEmpty(p))
-      VDOP = atof(p); // last before checksum
+      VDOP = parseFloat(p); // last before checksum
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "TOP")) { //*****************************TOP
+  case nmeaId("TOP"): { //***************************************************TOP
     // See:
     // https://learn.adafruit.com/adafruit-ultimate-gps-featherwing/antenna-options
     // There is an output sentence that will tell you the status of the
     // antenna. $PGTOP,11,x where x is the status number. If x is 3 that means
     // it is using the external antenna. If x is 2 it's using the internal
-    p = strchr(p, ',') + 1;
+    p = field(2);
     parseAntenna(p);
+    break;
   }
 
-#ifdef NMEA_EXTENSIONS // Sentences not required for basic GPS functionality
-  else if (!strcmp(thisSentence, "APB")) { //*******************************APB
-    // from Actisense NGW-1 from SH CP150C
-    return false;
-
-  } else if (!strcmp(thisSentence, "DBT")) { //*****************************DBT
-    // from Actisense NGW-1
-    // feet, metres, fathoms below transducer coerced to water depth from
-    // surface in metres
-    if (!isEmpty(p))
-      newDataValue(NMEA_DEPTH,
-                   (nmea_float_t)atof(p) * 0.3048f + depthToTransducer);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_DEPTH, (nmea_float_t)atof(p) + depthToTransducer);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_DEPTH,
-                   (nmea_float_t)atof(p) * 6 * 0.3048f + depthToTransducer);
-
-  } else if (!strcmp(thisSentence, "DPT")) { //*****************************DPT
-    // from Actisense NGW-1
-    return false;
-
-  } else if (!strcmp(thisSentence, "GSV")) { //*****************************GSV
-    // from Actisense NGW-1
-    return false;
+  case nmeaId("MTK"): { //***************************************************MTK
+    // responses from the GPS module to PMTK commands, e.g. $PMTK001,220,3
+    if (!decodeMTK())
+      return false;
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "HDG")) { //*****************************HDG
+#ifdef NMEA_EXTENSIONS // Sentences not required for basic GPS functionality
+  case nmeaId("APB"): { //***************************************************APB
     // from Actisense NGW-1 from SH CP150C
-    return false;
-
-  } else if (!strcmp(thisSentence, "HDM")) { //*****************************HDM
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDG, atof(p)); // skip the rest
-
-  } else if (!strcmp(thisSentence, "HDT")) { //*****************************HDT
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDT, atof(p)); // skip the rest
-
-  } else if (!strcmp(thisSentence, "MDA")) { //*****************************MDA
-    // from Actisense NGW-1
-    if (!isEmpty(p))
-      newDataValue(NMEA_BAROMETER, atof(p) * 3386.39);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_BAROMETER, atof(p) * 100000);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    nmea_float_t T = 100000.;
-    char u = 'C';
-    if (!isEmpty(p))
-      T = atof(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      u = *p;
-    p = strchr(p, ',') + 1;
-    if (u != 'C') {
-      T = (T - 32) / 1.8f;
-      u = 'C';
-    } // coerce to C
-    if (T < 1000)
-      newDataValue(NMEA_TEMPERATURE_AIR, T);
-    T = 100000.;
-    u = 'C';
-    if (!isEmpty(p))
-      T = atof(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      u = *p;
-    p = strchr(p, ',') + 1;
-    if (u != 'C') {
-      T = (T - 32) / 1.8f;
-      u = 'C';
+    // APB Autopilot Sentence "B"
+    //       1 2 3   4 5 6 7 8   9 10   11  12 13  14
+    //       | | |   | | | | |   | |    |   |  |   |
+    //$--APB,A,A,x.x,a,N,A,A,x.x,a,c--c,x.x,a,x.x,a*hh
+    // 1) Status, V = Loran-C blink or SNR warning 2) V = cycle lock warning
+    // 3) Cross track error magnitude 4) Direction to steer, L or R
+    // 5) Cross track units, N 6) A = arrival circle entered
+    // 7) A = perpendicular passed at waypoint
+    // 8) Bearing origin to destination 9) M or T
+    // 10) Destination waypoint ID
+    // 11) Bearing present position to destination 12) M or T
+    // 13) Heading to steer to destination 14) M or T
+    p = field(3);
+    const char *dir = field(4);
+    if (!isEmpty(p) && (*dir == 'L' || *dir == 'R')) {
+      nmea_float_t xte = parseFloat(p);
+      newDataValue(NMEA_XTE, *dir == 'L' ? -xte : xte);
     }
-    if (T < 1000)
-      newDataValue(NMEA_TEMPERATURE_WATER, T);
-    if (!isEmpty(p))
-      newDataValue(NMEA_HUMIDITY, atof(p)); // skip the rest
-
-  } else if (!strcmp(thisSentence, "MTW")) { //*****************************MTW
-    nmea_float_t T = 100000.;
-    char u = 'C';
-    if (!isEmpty(p))
-      T = atof(p);
-    p = strchr(p, ',') + 1;
+    p = field(10);
     if (!isEmpty(p))
-      u = *p; // last before checksum
-    if (u != 'C') {
-      T = (T - 32) / 1.8f;
-      u = 'C';
-    }
-    if (T < 1000)
-      newDataValue(NMEA_TEMPERATURE_WATER, T);
+      parseStr(toID, p, NMEA_MAX_WP_ID);
+    p = field(11);
+    if (!isEmpty(p) && *field(12) == 'T')
+      newDataValue(NMEA_COGWP, parseFloat(p));
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "MWD")) { //*****************************MWD
+  case nmeaId("GSV"): { //***************************************************GSV
     // from Actisense NGW-1
-    return false;
+    if (!decodeGSV())
+      return false;
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "MWV")) { //*****************************MWV
+  case nmeaId("MWV"): { //***************************************************MWV
     // from Actisense NGW-1
     nmea_float_t ang = 100000.;
     char ref = 'T';
     if (!isEmpty(p))
-      ang = atof(p);
-    p = strchr(p, ',') + 1;
+      ang = parseFloat(p);
+    p = field(2);
     if (!isEmpty(p))
       ref = *p;
-    p = strchr(p, ',') + 1;
+    p = field(3);
     nmea_float_t spd = 100000.;
     if (!isEmpty(p))
-      spd = atof(p);
-    p = strchr(p, ',') + 1;
+      spd = parseFloat(p);
+    p = field(4);
     char units = 'N';
     if (!isEmpty(p))
       units = *p;
-    p = strchr(p, ',') + 1;
+    p = field(5);
     char stat = 'A';
     if (!isEmpty(p))
       stat = *p; // last before checksum
@@ -319,8 +323,10 @@ bool Adafruit_GPS::parse(char *nmea) {
       if (spd < 1000.0f && stat == 'A')
         newDataValue(NMEA_TWS, spd);
     }
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "RMB")) { //*****************************RMB
+  case nmeaId("RMB"): { //***************************************************RMB
     // from Actisense NGW-1 from SH CP150C
     // RMB Recommended Minimum Navigation Information
     //       1 2   3 4    5    6       7 8        9 10  11 12  13 14
@@ -337,15 +343,15 @@ bool Adafruit_GPS::parse(char *nmea) {
     // 11) Bearing to destination in degrees True
     // 12) Destination closing velocity in knots
     // 13) Arrival Status, A = Arrival Circle Entered 14) Checksum
-    p = strchr(p, ',') + 1; // skip status
+    p = field(2); // skip status
     nmea_float_t xte = 100000.;
     char xteDir = 'X';
     if (!isEmpty(p))
-      xte = atof(p);
-    p = strchr(p, ',') + 1;
+      xte = parseFloat(p);
+    p = field(3);
     if (!isEmpty(p))
       xteDir = *p;
-    p = strchr(p, ',') + 1;
+    p = field(4);
     if (xte < 10000.0f && xteDir != 'X') {
       if (xteDir == 'L')
         xte *= -1.0f;
@@ -353,10 +359,10 @@ bool Adafruit_GPS::parse(char *nmea) {
     }
     if (!isEmpty(p))
       parseStr(toID, p, NMEA_MAX_WP_ID);
-    p = strchr(p, ',') + 1;
+    p = field(5);
     if (!isEmpty(p))
       parseStr(fromID, p, NMEA_MAX_WP_ID);
-    p = strchr(p, ',') + 1;
+    p = field(6);
     nmea_float_t latitudeWP = 0;
     nmea_float_t longitudeWP = 0;
     int32_t latitude_fixedWP = 0;
@@ -375,8 +381,7 @@ bool Adafruit_GPS::parse(char *nmea) {
       else
         newDataValue(NMEA_LATWP, latitudeDegreesWP);
     }
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    p = field(8);
     // parse out both longitude and direction for WayPoint, then go to next
     // field, or fail
     if (!isEmpty(p)) {
@@ -386,91 +391,69 @@ bool Adafruit_GPS::parse(char *nmea) {
       else
         newDataValue(NMEA_LONWP, longitudeDegreesWP);
     }
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    p = field(10);
     if (!isEmpty(p))
-      newDataValue(NMEA_DISTWP, atof(p));
-    p = strchr(p, ',') + 1;
+      newDataValue(NMEA_DISTWP, parseFloat(p));
+    p = field(11);
     if (!isEmpty(p))
-      newDataValue(NMEA_COGWP, atof(p));
-    p = strchr(p, ',') + 1;
+      newDataValue(NMEA_COGWP, parseFloat(p));
+    p = field(12);
     if (!isEmpty(p))
-      newDataValue(NMEA_VMGWP, atof(p)); // skip arrival flag
-
-  } else if (!strcmp(thisSentence, "ROT")) { //*****************************ROT
-    return false;
-
-  } else if (!strcmp(thisSentence, "RPM")) { //*****************************RPM
-    return false;
+      newDataValue(NMEA_VMGWP, parseFloat(p)); // skip arrival flag
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "RSA")) { //*****************************RSA
-    // from Actisense NGW-1
-    return false;
+  case nmeaId("RPM"): { //***************************************************RPM
+    // RPM Revolutions
+    //       1 2 3   4   5
+    //       | | |   |   |
+    //$--RPM,a,x,x.x,x.x,A*hh
+    // 1) Source; S = Shaft, E = Engine 2) Engine or shaft number
+    // 3) Speed, Revolutions per minute 4) Propeller pitch, % of maximum
+    // 5) Status, A means data is valid
+    // Engine or shaft 1 and 2 go to the motor 1 and 2 values
+    uint8_t n = atoi(field(2));
+    p = field(3);
+    if ((n != 1 && n != 2) || isEmpty(p) || *field(5) != 'A')
+      return false;
+    newDataValue(n == 1 ? NMEA_RPM_M1 : NMEA_RPM_M2, parseFloat(p));
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "TXT")) { //*****************************TXT
+  case nmeaId("TXT"): { //***************************************************TXT
     if (!isEmpty(p))
       txtTot = atoi(p);
-    p = strchr(p, ',') + 1;
+    p = field(2);
     if (!isEmpty(p))
       txtN = atoi(p);
-    p = strchr(p, ',') + 1;
+    p = field(3);
     if (!isEmpty(p))
       txtID = atoi(p);
-    p = strchr(p, ',') + 1;
+    p = field(4);
     if (!isEmpty(p))
       parseStr(txtTXT, p, 61); // copy the text to NMEA TXT max of 61 characters
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "VDR")) { //*****************************VDR
-    // from Actisense NGW-1
-    return false;
-
-  } else if (!strcmp(thisSentence, "VHW")) { //*****************************VHW
-    // from Actisense NGW-1
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDT, atof(p));
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDG, atof(p));
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_VTW, atof(p)); // skip the other units
-
-  } else if (!strcmp(thisSentence, "VLW")) { //*****************************VLW
-    // from Actisense NGW-1
-    if (!isEmpty(p))
-      newDataValue(NMEA_LOG, atof(p));
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_LOGR, atof(p)); // skip the other units
-
-  } else if (!strcmp(thisSentence, "VPW")) { //*****************************VPW
-    // knots, metres/s coerced to knots
-    nmea_float_t vmg = 100000.;
-    if (!isEmpty(p))
-      vmg = atof(p);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      vmg = atof(p) * 0.3048 * 3600. / 6000.; // skip units
-    if (vmg < 1000.0f)
-      newDataValue(NMEA_VMG, vmg);
-  } else if (!strcmp(thisSentence, "VTG")) { //*****************************VTG
-    // from Actisense NGW-1 from SH CP150C
-    return false;
+  case nmeaId("VDM"):   //***************************************************VDM
+  case nmeaId("VDO"): { //***************************************************VDO
+    // AIS messages, decoded in NMEA_ais.cpp. Only the last fragment of a
+    // message updates a vessel, so the others return false.
+    if (!decodeAIS())
+      return false;
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "VWR")) { //*****************************VWR
+  case nmeaId("VWR"): { //***************************************************VWR
     // from Actisense NGW-1
     nmea_float_t ang = 1000.;
     if (!isEmpty(p))
-      ang = atof(p);
-    p = strchr(p, ',') + 1;
+      ang = parseFloat(p);
+    p = field(2);
     char ref = ' ';
     if (!isEmpty(p))
       ref = *p;
-    p = strchr(p, ',') + 1;
+    p = field(3);
     if (ref == 'L')
       ang *= -1;
     if (ang < 1000.0f)
@@ -478,20 +461,20 @@ bool Adafruit_GPS::parse(char *nmea) {
     nmea_float_t ws = 0.0;
     char units = 'X';
     if (!isEmpty(p))
-      ws = atof(p);
-    p = strchr(p, ',') + 1; // knots
+      ws = parseFloat(p);
+    p = field(4); // knots
     if (!isEmpty(p))
       units = *p;
-    p = strchr(p, ',') + 1;
+    p = field(5);
     if (!isEmpty(p))
-      ws = atof(p);
-    p = strchr(p, ',') + 1; // meters / second
+      ws = parseFloat(p);
+    p = field(6); // meters / second
     if (!isEmpty(p))
       units = *p;
-    p = strchr(p, ',') + 1; // M
+    p = field(7); // M
     if (!isEmpty(p))
-      ws = atof(p);
-    p = strchr(p, ',') + 1; // kilometers / hour can be converted back to knots
+      ws = parseFloat(p);
+    p = field(8); // kilometers / hour can be converted back to knots
     if (!isEmpty(p))
       units = *p; // last before checksum
     if (units == 'M') {
@@ -508,47 +491,455 @@ bool Adafruit_GPS::parse(char *nmea) {
     } // convert miles / hr to knots
     if (units == 'N')
       newDataValue(NMEA_AWS, ws); // store the final result
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "WCV")) { //*****************************WCV
-    // from SH CP150C
-    if (!isEmpty(p))
-      newDataValue(NMEA_VMGWP, atof(p)); // skip the rest
-
-  } else if (!strcmp(thisSentence, "XTE")) { //*****************************XTE
+  case nmeaId("XTE"): { //***************************************************XTE
     // from Actisense NGW-1 from SH CP150C
-    p = strchr(p, ',') + 1; // skip status 1
-    p = strchr(p, ',') + 1; // skip status 2
+    p = field(3); // skip status 1 and status 2
     nmea_float_t xte = 100000.;
     char xteDir = 'X';
     if (!isEmpty(p))
-      xte = atof(p);
-    p = strchr(p, ',') + 1;
+      xte = parseFloat(p);
+    p = field(4);
     if (!isEmpty(p))
       xteDir = *p;
-    p = strchr(p, ',') + 1;
+    p = field(5);
     if (xte < 10000.0f && xteDir != 'X') {
       if (xteDir == 'L')
         xte *= -1.0f;
       newDataValue(NMEA_XTE, xte);
     } // skip units
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "ZDA")) { //*****************************ZDA
+  case nmeaId("ZDA"): { //***************************************************ZDA
     // from Actisense NGW-1
-    return false;
+    //       1         2  3  4    5  6
+    //       |         |  |  |    |  |
+    //$--ZDA,hhmmss.ss,xx,xx,xxxx,xx,xx*hh
+    // 1) Time (UTC) 2) Day 3) Month 4) Year
+    // 5) Local zone hours 6) Local zone minutes, both skipped
+    if (isEmpty(p) || isEmpty(field(4)))
+      return false;
+    parseTime(p);
+    day = atoi(field(2));
+    month = atoi(field(3));
+    year = atoi(field(4)) % 100; // two digits, the same as from RMC
+    break;
   }
 #endif // NMEA_EXTENSIONS
 
-  else {
+  default:
+#ifdef NMEA_EXTENSIONS
+    if (decodeSchema()) // nothing special, so straight from the schema table
+      break;
+#endif
     return false; // didn't find the required sentence definition
   }
 
   // Record the successful parsing of where the last data came from and when
-  strcpy(lastSource, thisSource);
-  strcpy(lastSentence, thisSentence);
+  lastSourceId = thisSourceId;
+  lastSentenceId = thisSentenceId;
   lastUpdate = millis();
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief Decode a $PMTK response from the GPS module, passing
+    acknowledgements and query replies on to the commands waiting for them
+    from sendTracked(). The message number or name follows PMTK in the
+    sentence ID, e.g. 001 or LOG.
+    @return true if it is a response that is decoded, false if not
+*/
+/**************************************************************************/
+bool Adafruit_GPS::decodeMTK(void) {
+  nmea_id_t msg = 0;
+  for (uint8_t i = 3; i < idLen && i < 6; i++)
+    msg |= (nmea_id_t)(uint8_t)idStart[i] << (8 * (6 - i));
+  const char *p = field(1);
+  switch (msg) {
+  case nmeaId("001"): // $PMTK001,cmd,flag acknowledges a command
+    if (isEmpty(p) || isEmpty(field(2)))
+      return false;
+    commandAnswered(atoi(p), 0, atoi(field(2)));
+    return true;
+
+  case nmeaId("010"): // $PMTK010,00x system message
+    if (isEmpty(p))
+      return false;
+    mtkSystem = atoi(p);
+    return true;
+
+  case nmeaId("LOG"): { // $PMTKLOG,serial,type,mode,config,interval,
+                        // distance,speed,status,records,percent LOCUS status
+    if (fieldCount < 11)
+      return false;
+    LOCUS_serial = atoi(p);
+    LOCUS_type = atoi(field(2));
+    p = field(3); // the mode is a set of bits, sometimes given in hex
+    LOCUS_mode = isAlpha(*p) ? strtol(p, NULL, 16) : atoi(p);
+    LOCUS_config = atoi(field(4));
+    LOCUS_interval = atoi(field(5));
+    LOCUS_distance = atoi(field(6));
+    LOCUS_speed = atoi(field(7));
+    LOCUS_status = !atoi(field(8));
+    LOCUS_records = atoi(field(9));
+    LOCUS_percent = atoi(field(10));
+    break;
+  }
+
+  case nmeaId("705"): // $PMTK705,release,build,model,... firmware release
+    parseStr(mtkRelease, p, sizeof(mtkRelease));
+    parseStr(mtkModel, field(3), sizeof(mtkModel));
+    break;
+
+  default: { // the reply to some other query, if one is waiting for it
+    uint8_t i = 0;
+    while (i < PMTK_MAX_COMMANDS &&
+           (!commands[i].command || commands[i].reply != msg))
+      i++;
+    if (i == PMTK_MAX_COMMANDS)
+      return false;
+    break;
+  }
+  }
+  commandAnswered(0, msg, PMTK_REPLIED);
+  return true;
+}
+
+#ifdef NMEA_EXTENSIONS
+/**************************************************************************/
+/*!
+    @brief Decode a sentence from its rows in the schema table, coercing
+    each field to the units of its data value. Where a value can come from
+    more than one field in different units, the first one filled in is used,
+    so each value is updated once. A field with the wrong unit letter after
+    it is skipped.
+    @return true if the sentence is in the table, false if not
+*/
+/**************************************************************************/
+bool Adafruit_GPS::decodeSchema(void) {
+  bool found = false;
+  uint8_t done = NMEA_MAX_INDEX; // value already set from an earlier field
+  for (const nmea_schema_t *s = schema;; s++) {
+    nmea_schema_t row;
+    memcpy_P(&row, s, sizeof(row));
+    if (!row.sentence)
+      return found;
+    if (row.sentence != thisSentenceId)
+      continue;
+    found = true;
+    if (row.idx >= NMEA_MAX_INDEX || row.idx == done)
+      continue;
+    const char *p = field(row.field);
+    if (isEmpty(p))
+      continue;
+    const char *u = field(row.field + 1);
+    if (row.tag && !isEmpty(u) && *u != row.tag)
+      continue;
+    nmea_float_t v = convertUnit(parseFloat(p), row.unit, true);
+    if (row.idx == NMEA_DEPTH)
+      v += depthToTransducer; // from the transducer to the surface
+    newDataValue((nmea_index_t)row.idx, v);
+    done = row.idx;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief Decode one GSV sentence into the back satellite table. The first
+    sentence of a group starts it off with the satellites of the other
+    systems from the front table, and the last one flips it to the front, so
+    a group for one system only replaces that system's satellites. A group
+    with a part missing is dropped and the front table stays as it was.
+    @return true if the sentence is in sequence, false if not
+*/
+/**************************************************************************/
+bool Adafruit_GPS::decodeGSV(void) {
+  //       1 2 3 4 5 6 7     n
+  //       | | | | | | |     |
+  //$--GSV,x,x,x,x,x,x,x,...*hh
+  // 1) total number of messages 2) message number 3) satellites in view
+  // 4) satellite number 5) elevation in degrees 6) azimuth in degrees to true
+  // 7) SNR in dB, up to four satellites like 4)-7), and NMEA 4.1 then adds a
+  // signal ID
+  uint8_t total = atoi(field(1));
+  uint8_t part = atoi(field(2));
+  char system = satelliteSystem(thisSourceId);
+  if (part == 0 || part > total)
+    return false;
+  nmea_satellites_t *back = &satTable[!satFront];
+  if (part == 1) {
+    const nmea_satellites_t *front = &satTable[satFront];
+    back->count = 0;
+    for (uint8_t i = 0; i < front->count; i++) {
+      if (front->system[i] == system)
+        continue;
+      uint8_t n = back->count++;
+      back->prn[n] = front->prn[i];
+      back->system[n] = front->system[i];
+      back->elevation[n] = front->elevation[i];
+      back->azimuth[n] = front->azimuth[i];
+      back->snr[n] = front->snr[i];
+      back->used[n] = front->used[i];
+    }
+    satSystem = system;
+  } else if (part != satPart + 1 || system != satSystem) {
+    satPart = 0; // lost one, so wait for the next group
+    return false;
+  }
+  satPart = part;
+  for (uint8_t f = 4; f <= 16 && f + 3 < fieldCount; f += 4) {
+    uint8_t prn = atoi(field(f));
+    if (prn == 0 || back->count >= NMEA_MAX_SATELLITES)
+      continue;
+    uint8_t n = back->count++;
+    back->prn[n] = prn;
+    back->system[n] = system;
+    back->elevation[n] = atoi(field(f + 1));
+    back->azimuth[n] = atoi(field(f + 2));
+    back->snr[n] = atoi(field(f + 3));
+    back->used[n] = satelliteUsed(system, prn);
+  }
+  if (part == total) {
+    __atomic_store_n(&satFront, !satFront, __ATOMIC_RELEASE);
+    satPart = 0;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Record the satellites used in the fix from the GSA sentence being
+    decoded and mark them in the front satellite table. A receiver with more
+    than one system sends a GSA for each in every fix, so the list carries
+    on until a system already in it comes round again or the fix time moves
+    on, whichever other sentences are being parsed.
+*/
+/**************************************************************************/
+void Adafruit_GPS::decodeGSAUsed(void) {
+  char system = satelliteSystem(thisSourceId);
+  const char *p = field(18); // NMEA 4.1 system ID for GNGSA
+  if (system == 'N' && *p >= '1' && *p <= '5')
+    system = "PLABQ"[*p - '1'];
+  uint8_t first = atoi(field(3));
+  if (system == 'N' && first >= 65 && first <= 96)
+    system = 'L'; // an NMEA 4.0 GNGSA, told apart by the GLONASS PRNs
+  uint32_t time = ((hour * 60UL + minute) * 60 + seconds) * 1000 + milliseconds;
+  bool again = usedCount == NMEA_MAX_SATELLITES || time != usedTime;
+  for (uint8_t i = 0; i < usedCount; i++)
+    again |= usedSystem[i] == system;
+  if (again)
+    usedCount = 0; // a new fix
+  usedTime = time;
+  for (uint8_t f = 3; f <= 14 && usedCount < NMEA_MAX_SATELLITES; f++) {
+    uint8_t prn = atoi(field(f));
+    if (prn) {
+      usedPrn[usedCount] = prn;
+      usedSystem[usedCount++] = system;
+    }
+  }
+  nmea_satellites_t *front = &satTable[satFront];
+  for (uint8_t i = 0; i < front->count; i++)
+    front->used[i] = satelliteUsed(front->system[i], front->prn[i]);
+}
+
+/**************************************************************************/
+/*!
+    @brief Check a satellite against the PRNs from the last GSA sentences.
+    @param system The satellite system letter, N if unknown
+    @param prn The satellite number
+    @return true if it was used in the fix
+*/
+/**************************************************************************/
+bool Adafruit_GPS::satelliteUsed(char system, uint8_t prn) {
+  for (uint8_t i = 0; i < usedCount; i++)
+    if (usedPrn[i] == prn &&
+        (usedSystem[i] == system || usedSystem[i] == 'N' || system == 'N'))
+      return true;
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Work out the satellite system from a talker ID.
+    @param source The packed talker ID, e.g. nmeaId("GL")
+    @return P for GPS, L for GLONASS, A for Galileo, B for BeiDou, Q for QZSS
+    or N if it could be any of them
+*/
+/**************************************************************************/
+char Adafruit_GPS::satelliteSystem(nmea_id_t source) {
+  if (source == nmeaId("BD"))
+    return 'B';
+  if ((source >> 24) != 'G')
+    return 'N';
+  return (char)(source >> 16);
+}
+
+/**************************************************************************/
+/*!
+    @brief Get the satellites in view from the last complete GSV groups,
+    e.g. to show signal strengths. The table isn't copied, so read it before
+    the GSV group after next is parsed.
+    @return Pointer to the satellite table
+*/
+/**************************************************************************/
+const nmea_satellites_t *Adafruit_GPS::satellitesInView(void) {
+  return &satTable[__atomic_load_n(&satFront, __ATOMIC_ACQUIRE)];
+}
+#endif // NMEA_EXTENSIONS
+
+/**************************************************************************/
+/*!
+    @brief Find the bit for a sentence that parse() can decode.
+    @param id The packed sentence ID
+    @return The NMEA_MASK_ bit for the sentence, or 0 if parse() can't
+    decode it
+*/
+/**************************************************************************/
+uint32_t Adafruit_GPS::sentenceBit(nmea_id_t id) {
+  switch (id) {
+  case nmeaId("GGA"):
+    return NMEA_MASK_GGA;
+  case nmeaId("GLL"):
+    return NMEA_MASK_GLL;
+  case nmeaId("GSA"):
+    return NMEA_MASK_GSA;
+  case nmeaId("RMC"):
+    return NMEA_MASK_RMC;
+  case nmeaId("TOP"):
+    return NMEA_MASK_TOP;
+  case nmeaId("MTK"):
+    return NMEA_MASK_MTK;
+#ifdef NMEA_EXTENSIONS
+  case nmeaId("DBT"):
+    return NMEA_MASK_DBT;
+  case nmeaId("HDM"):
+    return NMEA_MASK_HDM;
+  case nmeaId("HDT"):
+    return NMEA_MASK_HDT;
+  case nmeaId("MDA"):
+    return NMEA_MASK_MDA;
+  case nmeaId("MTW"):
+    return NMEA_MASK_MTW;
+  case nmeaId("MWV"):
+    return NMEA_MASK_MWV;
+  case nmeaId("APB"): // the same waypoint details as RMB
+  case nmeaId("RMB"):
+    return NMEA_MASK_RMB;
+  case nmeaId("TXT"):
+    return NMEA_MASK_TXT;
+  case nmeaId("VHW"):
+    return NMEA_MASK_VHW;
+  case nmeaId("VLW"):
+    return NMEA_MASK_VLW;
+  case nmeaId("VPW"):
+    return NMEA_MASK_VPW;
+  case nmeaId("VWR"):
+    return NMEA_MASK_VWR;
+  case nmeaId("WCV"):
+    return NMEA_MASK_WCV;
+  case nmeaId("XTE"):
+    return NMEA_MASK_XTE;
+  case nmeaId("DPT"):
+    return NMEA_MASK_DPT;
+  case nmeaId("HDG"):
+    return NMEA_MASK_HDG;
+  case nmeaId("MWD"):
+    return NMEA_MASK_MWD;
+  case nmeaId("VTG"):
+    return NMEA_MASK_VTG;
+  case nmeaId("GSV"):
+    return NMEA_MASK_GSV;
+  case nmeaId("VDM"):
+    return NMEA_MASK_VDM;
+  case nmeaId("VDO"):
+    return NMEA_MASK_VDO;
+  case nmeaId("ROT"):
+    return NMEA_MASK_ROT;
+  case nmeaId("RPM"):
+    return NMEA_MASK_RPM;
+  case nmeaId("RSA"):
+    return NMEA_MASK_RSA;
+  case nmeaId("VDR"):
+    return NMEA_MASK_VDR;
+  case nmeaId("ZDA"):
+    return NMEA_MASK_ZDA;
+#endif
+  default:
+    return 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief Choose which sentences parse() decodes. Any others are checked
+    and then skipped without looking at their fields, and parse() returns
+    false for them. NMEA_SENTENCE_MASK sets the starting choice at compile
+    time, which is all of them unless it is defined. $PMTK replies are
+    decoded whatever the choice, so that sendTracked() and the LOCUS
+    functions still see their answers.
+    @param sentences NMEA_MASK_ bits or'ed together, e.g.
+    NMEA_MASK_RMC | NMEA_MASK_GGA, or 0xFFFFFFFF for all of them
+*/
+/**************************************************************************/
+void Adafruit_GPS::wantSentences(uint32_t sentences) {
+  sentenceMask = sentences;
+}
+
+/**************************************************************************/
+/*!
+    @brief Register a function for parse() to call each time it successfully
+    parses a particular sentence, so that a sketch only does work when the
+    data it needs arrives, e.g.
+
+      gps.onSentence(nmeaId("RMC"), gotRMC);
+
+    then call update() from loop(). One handler per sentence, registering
+    again replaces it and a NULL handler removes it. nmeaId("") calls the
+    handler for every sentence parsed.
+    @param sentence The sentence ID code, e.g. nmeaId("GGA")
+    @param handler The function to call, or NULL to remove it
+    @return true if registered, false if all NMEA_MAX_HANDLERS are in use
+*/
+/**************************************************************************/
+bool Adafruit_GPS::onSentence(nmea_id_t sentence,
+                              nmea_sentence_handler_t handler) {
+  int8_t slot = -1;
+  for (uint8_t i = 0; i < NMEA_MAX_HANDLERS; i++) {
+    if (sentenceHandlers[i].handler && sentenceHandlers[i].sentence == sentence)
+      slot = i; // replace or remove the existing one
+    else if (slot < 0 && !sentenceHandlers[i].handler)
+      slot = i; // or take the first free one
+  }
+  if (slot < 0)
+    return handler == NULL; // nothing to remove is fine, no room is not
+  sentenceHandlers[slot].sentence = sentence;
+  sentenceHandlers[slot].handler = handler;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Call the handlers for the sentence that was just parsed, then for
+    each data value it updated.
+*/
+/**************************************************************************/
+void Adafruit_GPS::dispatch(void) {
+  for (uint8_t i = 0; i < NMEA_MAX_HANDLERS; i++) {
+    nmea_id_t wanted = sentenceHandlers[i].sentence;
+    if (sentenceHandlers[i].handler && (!wanted || wanted == thisSentenceId))
+      sentenceHandlers[i].handler(this, thisSentenceId);
+  }
+#ifdef NMEA_EXTENSIONS
+  for (uint8_t i = 0; i < NMEA_MAX_INDEX; i++)
+    if (valueHandlers[i] && (valUpdated[i / 8] & (1 << (i % 8))))
+      valueHandlers[i](this, (nmea_index_t)i, &val[i]);
+#endif
+}
+
 /**************************************************************************/
 /*!
     @brief Check an NMEA string for basic format, valid source ID and valid
@@ -559,78 +950,188 @@ bool Adafruit_GPS::parse(char *nmea) {
 */
 /**************************************************************************/
 bool Adafruit_GPS::check(char *nmea) {
+  bool ok = check(nmea, strlen(nmea));
+  nameIds(); // fill in the strings for older sketches
+  return ok;
+}
+
+/**************************************************************************/
+/*!
+    @brief Check an NMEA sentence in place for basic format, valid source ID
+    and valid sentence ID, without copying it or needing it to be 0
+    terminated. Update the values of thisCheck, thisSourceId and
+    thisSentenceId.
+    @param nmea Pointer to the start of the sentence
+    @param len Number of characters in the sentence, with or without CR/LF
+    @return True if well formed, false if it has problems
+*/
+/**************************************************************************/
+bool Adafruit_GPS::check(const char *nmea, size_t len) {
   thisCheck = 0; // new check
-  *thisSentence = *thisSource = 0;
-  if (*nmea != '$' && *nmea != '!')
+  thisSourceId = thisSentenceId = 0;
+  idStart = NULL;
+  idLen = 0;
+  if (len == 0 || (*nmea != '$' && *nmea != '!'))
     return false; // doesn't start with $ or !
   else
     thisCheck += NMEA_HAS_DOLLAR;
-  // do checksum check -- first look if we even have one -- ignore all but last
-  // *
-  char *ast = nmea; // not strchr(nmea,'*'); for first *
-  while (*ast)
-    ast++; // go to the end
-  while (*ast != '*' && ast > nmea)
-    ast--; // then back to * if it's there
-  if (*ast != '*')
-    return false; // there is no asterisk
-  else {
+  const char *ast;
+  if (nmea == (char *)lastline && qHeld && lastInfo.star) {
+    // read() already worked out the checksum as the line came in
+    if (!lastInfo.checksumOK)
+      return false; // bad checksum :(
+    ast = nmea + lastInfo.star;
+    thisCheck += NMEA_HAS_CHECKSUM;
+  } else {
+    // do checksum check -- first look if we even have one -- ignore all but
+    // last *
+    ast = nmea + len - 1; // not memchr(nmea, '*', len); for first *
+    while (*ast != '*' && ast > nmea)
+      ast--; // back to * if it's there
+    if (*ast != '*' || ast + 2 >= nmea + len)
+      return false; // there is no asterisk, or no room for the checksum
     uint16_t sum = parseHex(*(ast + 1)) * 16; // extract checksum
     sum += parseHex(*(ast + 2));
-    char *p = nmea; // check checksum
-    for (char *p1 = p + 1; p1 < ast; p1++)
+    for (const char *p1 = nmea + 1; p1 < ast; p1++)
       sum ^= *p1;
     if (sum != 0)
       return false; // bad checksum :(
     else
       thisCheck += NMEA_HAS_CHECKSUM;
   }
-  // extract source of variable length
-  char *p = nmea + 1;
-  const char *src = tokenOnList(p, sources);
-  if (src) {
-    strcpy(thisSource, src);
+  fieldEnd = ast; // no field lookups past the checksum
+  // extract source of variable length, trying two letters before one so
+  // that PG wins over P
+  const char *p = nmea + 1;
+  for (uint8_t n = 2; n > 0 && !thisSourceId; n--) {
+    nmea_id_t src = 0;
+    for (uint8_t i = 0; i < n; i++)
+      src |= (nmea_id_t)(uint8_t)p[i] << (8 * (3 - i));
+    if (p + n < ast && sourceKnown(src)) {
+      thisSourceId = src;
+      p += n;
+    }
+  }
+  if (thisSourceId)
     thisCheck += NMEA_HAS_SOURCE;
-  } else
+  else
     return false;
-  p += strlen(src);
-  // extract sentence id and check if parsed
-  const char *snc = tokenOnList(p, sentences_parsed);
-  if (snc) {
-    strcpy(thisSentence, snc);
-    thisCheck += NMEA_HAS_SENTENCE_P + NMEA_HAS_SENTENCE;
-  } else { // check if known
-    snc = tokenOnList(p, sentences_known);
-    if (snc) {
-      strcpy(thisSentence, snc);
-      thisCheck += NMEA_HAS_SENTENCE;
-      return false; // known but not parsed
-    } else {
-      parseStr(thisSentence, p, NMEA_MAX_SENTENCE_ID);
-      return false; // unknown
-    }
+  idStart = p;
+  // pack the sentence id up to the first field, then check if parsed
+  while (p + idLen < ast && p[idLen] != ',' &&
+         idLen < NMEA_MAX_SENTENCE_ID - 1) {
+    if (idLen < 4)
+      thisSentenceId |= (nmea_id_t)(uint8_t)p[idLen] << (8 * (3 - idLen));
+    idLen++;
   }
-  return true; // passed all the tests
+  if (thisSourceId == nmeaId("P") && idLen > 3 &&
+      (thisSentenceId & 0xFFFFFF00UL) == nmeaId("MTK"))
+    thisSentenceId = nmeaId("MTK"); // $PMTKnnn, decodeMTK() reads the nnn
+  else if (idLen > 4)
+    return false; // longer than any we know, e.g. proprietary
+  int found = sentenceCheck(thisSentenceId);
+  thisCheck += found;
+  return found == NMEA_HAS_SENTENCE_P + NMEA_HAS_SENTENCE; // parseable?
 }
 
 /**************************************************************************/
 /*!
-    @brief Check if a token at the start of a string is on a list.
-    @param token Pointer to the string
-    @param list A list of strings, with the final entry starting "ZZ"
-    @return Pointer to the found token, or NULL if it fails
+    @brief Look up a sentence ID to see what parse() can do with it. A switch
+    on the packed ID, so the cost doesn't depend on how many sentences there
+    are or where the ID sits in the list.
+    @param id The packed sentence ID
+    @return NMEA_HAS_SENTENCE_P + NMEA_HAS_SENTENCE if parse() decodes it,
+    NMEA_HAS_SENTENCE if it is known but not decoded, or 0 if unknown
 */
 /**************************************************************************/
-const char *Adafruit_GPS::tokenOnList(char *token, const char **list) {
-  int i = 0; // index in the list
-  while (strncmp(list[i], "ZZ", 2) &&
-         i < 1000) { // stop at terminator and don't crash without it
-    // test for a match on the sentence name
-    if (!strncmp((const char *)list[i], (const char *)token, strlen(list[i])))
-      return list[i];
-    i++;
+int Adafruit_GPS::sentenceCheck(nmea_id_t id) {
+  if (sentenceBit(id))
+    return NMEA_HAS_SENTENCE_P + NMEA_HAS_SENTENCE;
+  switch (id) {
+#ifndef NMEA_EXTENSIONS
+  case nmeaId("DBT"):
+  case nmeaId("HDM"):
+  case nmeaId("HDT"):
+    return NMEA_HAS_SENTENCE;
+#endif
+  default:
+    return 0;
   }
-  return NULL; // couldn't find a match
+}
+
+/**************************************************************************/
+/*!
+    @brief Fill in thisSource and thisSentence from the IDs found by the last
+    check(), for sketches that still use the strings.
+*/
+/**************************************************************************/
+void Adafruit_GPS::nameIds(void) {
+  idString(thisSourceId, thisSource);
+  if (idStart)
+    memcpy(thisSentence, idStart, idLen);
+  thisSentence[idLen] = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Unpack a source or sentence ID code into a string.
+    @param id The ID code, e.g. thisSentenceId or nmeaId("GGA")
+    @param buff Pointer to a buffer with room for at least 5 characters
+    @return Pointer to the string buffer
+*/
+/**************************************************************************/
+char *Adafruit_GPS::idString(nmea_id_t id, char *buff) {
+  uint8_t n = 0;
+  for (int8_t shift = 24; shift >= 0 && (id >> shift) & 0xFF; shift -= 8)
+    buff[n++] = (id >> shift) & 0xFF;
+  buff[n] = 0;
+  return buff;
+}
+
+/**************************************************************************/
+/*!
+    @brief Is a talker ID one that check() recognises, either built in or
+    added with addSource()?
+    @param source The packed talker ID
+    @return true if known
+*/
+/**************************************************************************/
+bool Adafruit_GPS::sourceKnown(nmea_id_t source) {
+  if (!source)
+    return false;
+  for (uint8_t i = 0; i < sizeof(builtinSources) / sizeof(nmea_id_t); i++)
+    if (pgm_read_dword(&builtinSources[i]) == source)
+      return true;
+  for (uint8_t i = 0; i < NMEA_MAX_EXTRA_SOURCES; i++)
+    if (extraSources[i] == source)
+      return true;
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add a talker ID for check() to accept, on top of the built in
+    ones, e.g. addSource("GL") for a GLONASS receiver. Shared by all of the
+    Adafruit_GPS objects in the sketch.
+    @param source The one or two letter talker ID
+    @return true if added or already known, false if there is no room left
+    in the NMEA_MAX_EXTRA_SOURCES slots or the ID is the wrong length
+*/
+/**************************************************************************/
+bool Adafruit_GPS::addSource(const char *source) {
+  size_t len = strlen(source);
+  if (len < 1 || len > 2)
+    return false;
+  nmea_id_t id = nmeaId(source);
+  if (sourceKnown(id))
+    return true;
+  for (uint8_t i = 0; i < NMEA_MAX_EXTRA_SOURCES; i++) {
+    if (!extraSources[i]) {
+      extraSources[i] = id;
+      return true;
+    }
+  }
+  return false;
 }
 
 /**************************************************************************/
@@ -677,23 +1178,20 @@ bool Adafruit_GPS::onList(char *nmea, const char **list) {
     @return true if successful, false if failed or no value
 */
 /**************************************************************************/
-bool Adafruit_GPS::parseCoord(char *pStart, nmea_float_t *angleDegrees,
+bool Adafruit_GPS::parseCoord(const char *pStart, nmea_float_t *angleDegrees,
                               nmea_float_t *angle, int32_t *angle_fixed,
                               char *dir) {
-  char *p = pStart;
+  const char *p = pStart;
   if (!isEmpty(p)) {
-    // get the number in DDDMM.mmmm format and break into components
-    char degreebuff[10] = {0}; // Ensure string is terminated after strncpy
-    char *e = strchr(p, '.');
-    if (e == NULL || e - p > 6)
-      return false;                // no decimal point in range
-    strncpy(degreebuff, p, e - p); // get DDDMM
-    long dddmm = atol(degreebuff);
+    // get the number in DDDMM.mmmm format and break into components, in
+    // integers so that the fixed point result is exact
+    uint32_t dddmm;
+    uint32_t decminutes; // the fraction after the decimal point, in millionths
+    if (!scanDecimal(p, &dddmm, &decminutes, 6) || dddmm > 18059)
+      return false;                       // no number in range
     long degrees = (dddmm / 100);         // truncate the minutes
     long minutes = dddmm - degrees * 100; // remove the degrees
-    p = e;                                // start from the decimal point
-    nmea_float_t decminutes = atof(e); // the fraction after the decimal point
-    p = strchr(p, ',') + 1;            // go to the next field
+    p = nextField(p);                     // go to the next field
 
     // get the NSEW direction as a character
     char nsew = 'X';
@@ -702,16 +1200,10 @@ bool Adafruit_GPS::parseCoord(char *pStart, nmea_float_t *angleDegrees,
     else
       return false; // no direction provided
 
-    // set the various numerical formats to their values
-    long fixed = degrees * 10000000 + (minutes * 10000000) / 60 +
-                 (decminutes * 10000000) / 60;
-    nmea_float_t ang = degrees * 100 + minutes + decminutes;
-    nmea_float_t deg = fixed / (nmea_float_t)10000000.;
-    if (nsew == 'S' ||
-        nsew == 'W') { // fixed and deg are signed, but DDDMM.mmmm is not
-      fixed = -fixed;
-      deg = -deg;
-    }
+    // set the various numerical formats to their values. A millionth of a
+    // minute is 1/6 of a 10000000th of a degree, rounded to the nearest
+    long fixed =
+        degrees * 10000000 + (minutes * 1000000 + (long)decminutes + 3) / 6;
 
     // reject directions that are not NSEW
     if (nsew != 'N' && nsew != 'S' && nsew != 'E' && nsew != 'W')
@@ -719,11 +1211,19 @@ bool Adafruit_GPS::parseCoord(char *pStart, nmea_float_t *angleDegrees,
 
     // reject angles that are out of range
     if (nsew == 'N' || nsew == 'S')
-      if (abs(deg) > 90)
+      if (fixed > 900000000)
         return false;
-    if (abs(deg) > 180)
+    if (fixed > 1800000000)
       return false;
 
+    nmea_float_t ang = degrees * 100 + minutes + decminutes / 1000000.0f;
+    nmea_float_t deg = fixed / (nmea_float_t)10000000.;
+    if (nsew == 'S' ||
+        nsew == 'W') { // fixed and deg are signed, but DDDMM.mmmm is not
+      fixed = -fixed;
+      deg = -deg;
+    }
+
     // store in locations passed as args
     if (angle != NULL)
       *angle = ang;
@@ -740,32 +1240,68 @@ bool Adafruit_GPS::parseCoord(char *pStart, nmea_float_t *angleDegrees,
 
 /**************************************************************************/
 /*!
-    @brief Parse a string token from pointer p to the next comma, asterisk
-    or end of string.
+    @brief Record where each comma separated field of the sentence being
+    parsed starts, in a single pass up to the checksum. Fields past
+    NMEA_MAX_FIELDS are ignored.
+    @param nmea Pointer to the start of the sentence, already check()ed
+    @return false if the sentence is too long to index
+*/
+/**************************************************************************/
+bool Adafruit_GPS::indexFields(const char *nmea) {
+  if (fieldEnd - nmea > 255)
+    return false; // far longer than NMEA-183 allows anyway
+  fieldBase = nmea;
+  fieldCount = 0;
+  fieldStart[fieldCount++] = 0;
+  for (uint8_t i = 0; nmea + i < fieldEnd; i++)
+    if (nmea[i] == ',' && fieldCount < NMEA_MAX_FIELDS)
+      fieldStart[fieldCount++] = i + 1;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Go straight to a field of the sentence being parsed, numbered as
+    in the NMEA-183 descriptions, with field 0 being the $ and sentence ID.
+    @param i The field number
+    @return Pointer to the start of the field, or to the * if the sentence
+    has no field i, so that it reads as empty
+*/
+/**************************************************************************/
+const char *Adafruit_GPS::field(uint8_t i) {
+  return i < fieldCount ? fieldBase + fieldStart[i] : fieldEnd;
+}
+
+/**************************************************************************/
+/*!
+    @brief Step to the start of the next comma separated field, without going
+    past the checksum of the sentence being parsed.
+    @param p Pointer into the sentence
+    @return Pointer to the character after the next comma, or to the * if
+    there are no more fields
+*/
+/**************************************************************************/
+const char *Adafruit_GPS::nextField(const char *p) {
+  while (p < fieldEnd && *p != ',')
+    p++;
+  return p < fieldEnd ? p + 1 : fieldEnd;
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse a string token from pointer p to the next comma or asterisk.
     @param buff Pointer to the buffer to store the string in
     @param p Pointer into a string
     @param n Max permitted size of string including terminating 0
     @return Pointer to the string buffer
 */
 /**************************************************************************/
-char *Adafruit_GPS::parseStr(char *buff, char *p, int n) {
-  char *e = strchr(p, ',');
+char *Adafruit_GPS::parseStr(char *buff, const char *p, int n) {
   int len = 0;
-  if (e) {
-    len = min(int(e - p), n - 1);
-    strncpy(buff, p, len); // copy up to the comma
-    buff[len] = 0;
-  } else {
-    e = strchr(p, '*');
-    if (e) {
-      len = min(int(e - p), n - 1);
-      strncpy(buff, p, len); // or up to the *
-      buff[e - p] = 0;
-    } else {
-      len = min((int)strlen(p), n - 1);
-      strncpy(buff, p, len); // or to the end or max capacity
-    }
-  }
+  while (p + len < fieldEnd && p[len] != ',' && len < n - 1)
+    len++; // up to the comma, the * or max capacity
+  memcpy(buff, p, len);
+  buff[len] = 0;
   return buff;
 }
 
@@ -777,24 +1313,78 @@ char *Adafruit_GPS::parseStr(char *buff, char *p, int n) {
     @return true if successful, false otherwise
 */
 /**************************************************************************/
-bool Adafruit_GPS::parseTime(char *p) {
-  if (!isEmpty(p)) { // get time
-    uint32_t time = atol(p);
+bool Adafruit_GPS::parseTime(const char *p) {
+  uint32_t time, ms;
+  if (!isEmpty(p) && scanDecimal(p, &time, &ms, 3)) { // get time
     hour = time / 10000;
     minute = (time % 10000) / 100;
     seconds = (time % 100);
-    char *dec = strchr(p, '.');
-    char *comstar = min(strchr(p, ','), strchr(p, '*'));
-    if (dec != NULL && comstar != NULL && dec < comstar)
-      milliseconds = atof(dec) * 1000;
-    else
-      milliseconds = 0;
+    milliseconds = ms;
     lastTime = sentTime;
     return true;
   }
   return false;
 }
 
+/**************************************************************************/
+/*!
+    @brief Scan a decimal number in an NMEA field using only integer
+    arithmetic, which is much quicker than atof() on processors without
+    floating point hardware. Any digits past the ones kept are rounded.
+    @param p Pointer to the first digit
+    @param whole Filled with the part before the decimal point
+    @param frac Filled with the part after the decimal point times
+    10^decimals, e.g. 5 for ".5" with 1 decimal, 500 with 3
+    @param decimals Number of decimal places to keep in frac, up to 9
+    @return true if there was at least one digit
+*/
+/**************************************************************************/
+bool Adafruit_GPS::scanDecimal(const char *p, uint32_t *whole, uint32_t *frac,
+                               uint8_t decimals) {
+  uint32_t w = 0, f = 0, one = 1; // one ends up as 10^decimals
+  bool digits = false;
+  while (*p >= '0' && *p <= '9') {
+    w = w * 10 + (*p++ - '0');
+    digits = true;
+  }
+  if (*p == '.')
+    p++;
+  for (uint8_t n = 0; n < decimals; n++) {
+    one *= 10;
+    f *= 10;
+    if (*p >= '0' && *p <= '9') {
+      f += *p++ - '0';
+      digits = true;
+    }
+  }
+  if (*p >= '5' && *p <= '9' && ++f == one) { // round up, maybe carrying
+    f = 0;
+    w++;
+  }
+  *whole = w;
+  *frac = f;
+  return digits;
+}
+
+/**************************************************************************/
+/*!
+    @brief Convert a decimal number in an NMEA field to floating point, with
+    one division instead of a call to atof().
+    @param p Pointer to the field
+    @return The value, 0 if there is no number
+*/
+/**************************************************************************/
+nmea_float_t Adafruit_GPS::parseFloat(const char *p) {
+  bool negative = *p == '-';
+  if (negative || *p == '+')
+    p++;
+  uint32_t whole, frac;
+  if (!scanDecimal(p, &whole, &frac, 6))
+    return 0;
+  nmea_float_t v = whole + frac / (nmea_float_t)1000000.;
+  return negative ? -v : v;
+}
+
 /**************************************************************************/
 /*!
     @brief Parse a part of an NMEA string for whether there is a fix
@@ -802,7 +1392,7 @@ bool Adafruit_GPS::parseTime(char *p) {
     @return True if we parsed it, false if it has invalid data
 */
 /**************************************************************************/
-bool Adafruit_GPS::parseFix(char *p) {
+bool Adafruit_GPS::parseFix(const char *p) {
   if (!isEmpty(p)) {
     if (p[0] == 'A') {
       fix = true;
@@ -823,7 +1413,7 @@ bool Adafruit_GPS::parseFix(char *p) {
     @return 3=external 2=internal 1=there was an antenna short or problem
 */
 /**************************************************************************/
-bool Adafruit_GPS::parseAntenna(char *p) {
+bool Adafruit_GPS::parseAntenna(const char *p) {
   if (!isEmpty(p)) {
     if (p[0] == '3') {
       antenna = 3;
@@ -847,7 +1437,7 @@ bool Adafruit_GPS::parseAntenna(char *p) {
     @return true if empty field, false if something there
 */
 /**************************************************************************/
-bool Adafruit_GPS::isEmpty(char *pStart) {
+bool Adafruit_GPS::isEmpty(const char *pStart) {
   if (',' != *pStart && '*' != *pStart && pStart != NULL)
     return false;
   else